@@ -0,0 +1,484 @@
+/**
+ * @file CB_Bench.c
+ * @brief Host micro-benchmarks and SPSC/MPSC stress tests for the ring buffers
+ *
+ * Reports ns/op and items/s for CircularBuffer, the typed rings, MPSCRing,
+ * TimedBuffer, CircularStats and SampleFilter over item sizes of 1, 4, 12 and
+ * 64 bytes and several fill levels, then runs multi-threaded producer/consumer
+ * tests that fail on lost, duplicated or reordered items.
+ *
+ * Linux only, the firmware build skips this file. Build and run from the
+ * repository root:
+ * @code
+ * gcc -std=gnu11 -O2 -Wall -Wextra -IInc Bench/CB_Bench.c Src/CircularBuffer.c \
+ *     Src/MPSCRing.c Src/TimedBuffer.c Src/CircularStats.c Src/SampleFilter.c \
+ *     -o cb_bench -lpthread && ./cb_bench [iterations]
+ * @endcode
+ * The exit status is non-zero if a stress test fails.
+ *
+ * @author [Nate Hunter]
+ * @date [16.10.2026]
+ * @version 1.0
+ */
+
+#if defined(__linux__)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "CircularBuffer.h"
+#include "CircularBufferTyped.h"
+#include "MPSCRing.h"
+#include "TimedBuffer.h"
+#include "CircularStats.h"
+#include "SampleFilter.h"
+
+#define BENCH_MAX_ITEM   64
+#define BENCH_RING_SIZE  255
+#define BENCH_STRESS_N   2000000u
+#define BENCH_SPAN_N     16
+
+typedef uint8_t Item12[12];
+typedef uint8_t Item64[64];
+
+CB_DEFINE(Ring1, uint8_t, 8)
+CB_DEFINE(Ring4, uint32_t, 8)
+CB_DEFINE(Ring12, Item12, 8)
+CB_DEFINE(Ring64, Item64, 8)
+CB_DEFINE(StressRing, uint32_t, 10)
+
+static const uint8_t item_sizes[] = { 1, 4, 12, 64 };
+static uint32_t iterations = 2000000u;
+static volatile uint32_t sink;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void report(const char *name, unsigned item_size, double ns, uint32_t ops, uint32_t items) {
+    printf("%-28s %3u B  %8.2f ns/op  %10.3f Mitems/s\n",
+           name, item_size, ns / ops, items * 1e3 / ns);
+}
+
+/* ---------------------------------------------------------------- CircularBuffer */
+
+static uint8_t cb_storage[BENCH_RING_SIZE * BENCH_MAX_ITEM];
+
+static void cb_setup(CircularBuffer *cb, uint8_t item_size, uint8_t policy) {
+    memset(cb, 0, sizeof(*cb));
+    cb->size = BENCH_RING_SIZE;
+    cb->item_size = item_size;
+    cb->policy = policy;
+    CB_InitStatic(cb, cb_storage);
+}
+
+static void bench_cb_push_pop(uint8_t item_size) {
+    static const uint8_t fills[] = { 0, 64, 128, BENCH_RING_SIZE - 2 };
+    CircularBuffer cb;
+    uint8_t item[BENCH_MAX_ITEM] = { 0 };
+    char name[32];
+
+    for (uint8_t f = 0; f < sizeof(fills); f++) {
+        cb_setup(&cb, item_size, CB_REJECT);
+        for (uint32_t v = 0; v < fills[f]; v++) CB_Push(&cb, item);
+
+        // Push then pop keeps the fill level constant through the run
+        double t0 = now_ns();
+        for (uint32_t i = 0; i < iterations; i++) {
+            item[0] = (uint8_t)i;
+            CB_Push(&cb, item);
+            CB_Pop(&cb, item);
+        }
+        double t = now_ns() - t0;
+        sink = item[0];
+        snprintf(name, sizeof(name), "CB_Push+CB_Pop fill %u", fills[f]);
+        report(name, item_size, t, iterations, iterations);
+    }
+}
+
+static void bench_cb_bulk(uint8_t item_size) {
+    CircularBuffer cb;
+    static uint8_t chunk[64 * BENCH_MAX_ITEM];
+    uint32_t rounds = iterations / 64;
+    cb_setup(&cb, item_size, CB_REJECT);
+
+    double t0 = now_ns();
+    for (uint32_t i = 0; i < rounds; i++) {
+        chunk[0] = (uint8_t)i;
+        CB_PushN(&cb, chunk, 64);
+        CB_PopN(&cb, chunk, 64);
+    }
+    double t = now_ns() - t0;
+    sink = chunk[0];
+    report("CB_PushN+CB_PopN (64)", item_size, t, rounds, rounds * 64);
+}
+
+static void bench_cb_span(uint8_t item_size) {
+    static const uint8_t fills[] = { 0, 64, 128, BENCH_RING_SIZE - 1 - BENCH_SPAN_N };
+    static uint8_t chunk[BENCH_SPAN_N * BENCH_MAX_ITEM];
+    uint32_t rounds = iterations / BENCH_SPAN_N;
+    CircularBuffer cb;
+    CB_Span span[2];
+    char name[32];
+
+    for (uint8_t f = 0; f < sizeof(fills); f++) {
+        cb_setup(&cb, item_size, CB_REJECT);
+        for (uint32_t v = 0; v < fills[f]; v++) CB_Push(&cb, chunk);
+
+        // Fill and drain BENCH_SPAN_N elements in place, split across the wrap when needed
+        double t0 = now_ns();
+        for (uint32_t i = 0; i < rounds; i++) {
+            uint32_t n = BENCH_SPAN_N;
+            chunk[0] = (uint8_t)i;
+            CB_Reserve(&cb, span);
+            uint32_t first = (span[0].count < n) ? span[0].count : n;
+            memcpy(span[0].ptr, chunk, first * item_size);
+            memcpy(span[1].ptr, chunk + first * item_size, (n - first) * item_size);
+            CB_Commit(&cb, n);
+
+            CB_Peek(&cb, span);
+            first = (span[0].count < n) ? span[0].count : n;
+            memcpy(chunk, span[0].ptr, first * item_size);
+            memcpy(chunk + first * item_size, span[1].ptr, (n - first) * item_size);
+            CB_Consume(&cb, n);
+        }
+        double t = now_ns() - t0;
+        sink = chunk[0];
+        snprintf(name, sizeof(name), "CB_Reserve+CB_Peek fill %u", fills[f]);
+        report(name, item_size, t, rounds, rounds * BENCH_SPAN_N);
+    }
+}
+
+static uint32_t sum_u32(const void *acc, const void *item) {
+    return *(const uint32_t*)acc + *(const uint32_t*)item;
+}
+
+static uint32_t div_u32(const void *acc, uint32_t count) {
+    return *(const uint32_t*)acc / count;
+}
+
+static uint32_t diff_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) ? x - y : y - x;
+}
+
+static void bench_cb_analytics(void) {
+    static const uint8_t fills[] = { 16, 64, 128, BENCH_RING_SIZE - 1 };
+    CircularBuffer cb;
+
+    for (uint8_t f = 0; f < sizeof(fills); f++) {
+        cb_setup(&cb, 4, CB_OVERWRITE);
+        // Start half way so the contents wrap around the end of the storage
+        cb.head = cb.tail = BENCH_RING_SIZE / 2;
+        for (uint32_t v = 0; v < fills[f]; v++) CB_Push(&cb, &v);
+
+        uint32_t calls = iterations / fills[f];
+        double t0 = now_ns();
+        for (uint32_t i = 0; i < calls; i++) sink = CB_Average(&cb, sum_u32, div_u32);
+        double t = now_ns() - t0;
+        printf("CB_Average fill %3u          %8.2f ns/call %8.2f ns/item\n", fills[f], t / calls, t / calls / fills[f]);
+
+        t0 = now_ns();
+        for (uint32_t i = 0; i < calls; i++) sink = CB_Diff(&cb, diff_u32);
+        t = now_ns() - t0;
+        printf("CB_Diff    fill %3u          %8.2f ns/call %8.2f ns/item\n", fills[f], t / calls, t / calls / fills[f]);
+
+        uint32_t total = 0;
+        t0 = now_ns();
+        for (uint32_t i = 0; i < calls; i++) {
+            CB_FOREACH(&cb, uint32_t, v) total += *v;
+        }
+        t = now_ns() - t0;
+        sink = total;
+        printf("CB_FOREACH fill %3u          %8.2f ns/call %8.2f ns/item\n", fills[f], t / calls, t / calls / fills[f]);
+    }
+}
+
+/* ---------------------------------------------------------------- Other rings */
+
+#define BENCH_TYPED(ring, size)                                         \
+    do {                                                                \
+        static ring##_t r;                                              \
+        ring##_item_t item;                                             \
+        memset(&item, 0, sizeof(item));                                 \
+        ring##_Init(&r);                                                \
+        double t0 = now_ns();                                           \
+        for (uint32_t i = 0; i < iterations; i++) {                     \
+            ((uint8_t*)&item)[0] = (uint8_t)i;                          \
+            ring##_Push(&r, &item);                                     \
+            ring##_Pop(&r, &item);                                      \
+        }                                                               \
+        double t = now_ns() - t0;                                       \
+        sink = ((uint8_t*)&item)[0];                                    \
+        report("Typed Push+Pop", size, t, iterations, iterations);      \
+    } while (0)
+
+static void bench_mpsc(uint8_t item_size) {
+    static uint32_t storage[MPSC_STORAGE_WORDS(256, BENCH_MAX_ITEM)];
+    MPSC_Ring r;
+    uint8_t item[BENCH_MAX_ITEM] = { 0 };
+    MPSC_Init(&r, storage, 256, item_size);
+
+    double t0 = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        item[0] = (uint8_t)i;
+        MPSC_Push(&r, item);
+        MPSC_Pop(&r, item);
+    }
+    double t = now_ns() - t0;
+    sink = item[0];
+    report("MPSC_Push+MPSC_Pop", item_size, t, iterations, iterations);
+}
+
+static void bench_timed(void) {
+    static uint32_t data[1024], stamps[1024];
+    TimedBuffer tb;
+    TB_Init(&tb, data, stamps, 1024, 4, 0);
+
+    double t0 = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) TB_Push(&tb, i * 3u, &i);
+    double t = now_ns() - t0;
+    report("TB_Push", 4, t, iterations, iterations);
+
+    uint32_t base = (iterations - 1024) * 3u;
+    t0 = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) sink = TB_FindAtOrAfter(&tb, base + (i & 1023u) * 3u);
+    t = now_ns() - t0;
+    report("TB_FindAtOrAfter (1024)", 4, t, iterations, iterations);
+}
+
+/** Moving average, EMA, median and FIR kernels for one SampleFilter sample type. */
+#define BENCH_SF(S, T, size, ema_init, coef)                                        \
+    do {                                                                            \
+        static T buf[64], data[512], hist[64];                                      \
+        static int16_t index[1024];                                                 \
+        static __typeof__(coef) coeffs[32];                                         \
+        SF_MA_##S ma;                                                               \
+        SF_EMA_##S ema;                                                             \
+        SF_Median_##S med;                                                          \
+        SF_FIR_##S fir;                                                             \
+        T y = 0;                                                                    \
+        double t0, t;                                                               \
+                                                                                    \
+        SF_MA_Init_##S(&ma, buf, 64);                                               \
+        t0 = now_ns();                                                              \
+        for (uint32_t i = 0; i < iterations; i++) y += SF_MA_Push_##S(&ma, (T)(int16_t)(i * 2654435761u >> 16)); \
+        t = now_ns() - t0;                                                          \
+        report("SF_MA_Push_" #S " (64)", size, t, iterations, iterations);          \
+                                                                                    \
+        SF_EMA_Init_##S(&ema, ema_init);                                            \
+        t0 = now_ns();                                                              \
+        for (uint32_t i = 0; i < iterations; i++) y += SF_EMA_Push_##S(&ema, (T)(int16_t)(i * 2654435761u >> 16)); \
+        t = now_ns() - t0;                                                          \
+        report("SF_EMA_Push_" #S, size, t, iterations, iterations);                 \
+                                                                                    \
+        SF_Median_Init_##S(&med, data, index, 512);                                 \
+        t0 = now_ns();                                                              \
+        for (uint32_t i = 0; i < iterations; i++) y += SF_Median_Push_##S(&med, (T)(int16_t)(i * 2654435761u >> 16)); \
+        t = now_ns() - t0;                                                          \
+        report("SF_Median_Push_" #S " (512)", size, t, iterations, iterations);     \
+                                                                                    \
+        for (uint8_t i = 0; i < 32; i++) coeffs[i] = coef;                          \
+        SF_FIR_Init_##S(&fir, coeffs, hist, 32, 1);                                 \
+        t0 = now_ns();                                                              \
+        for (uint32_t i = 0; i < iterations; i++) SF_FIR_Push_##S(&fir, (T)(int16_t)i, &y); \
+        t = now_ns() - t0;                                                          \
+        report("SF_FIR_Push_" #S " (32 taps)", size, t, iterations, iterations);    \
+        sink = (uint32_t)y;                                                         \
+    } while (0)
+
+static void bench_filters(void) {
+    static uint32_t stats[CBS_STORAGE_WORDS(512)];
+    CBS_Window w;
+
+    CBS_Init(&w, stats, 512);
+    double t0 = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) CBS_Push(&w, (int32_t)(i * 2654435761u) >> 16);
+    double t = now_ns() - t0;
+    sink = CBS_MaxDelta(&w);
+    report("CBS_Push (512)", 4, t, iterations, iterations);
+
+    BENCH_SF(i16, int16_t, 2, 4, (int16_t)1024);
+    BENCH_SF(i32, int32_t, 4, 4, (int16_t)1024);
+    BENCH_SF(f32, float, 4, 0.0625f, 1.0f / 32);
+}
+
+/* ---------------------------------------------------------------- Stress tests */
+
+static CircularBuffer stress_cb;
+static StressRing_t stress_typed;
+static MPSC_Ring stress_mpsc;
+static volatile int stress_done;
+
+static volatile int stress_stop;
+static volatile uint32_t stress_pushed;
+
+static void *cb_producer(void *arg) {
+    (void)arg;
+    uint32_t i = 0;
+    // REJECT pushes a fixed count and retries until each item fits,
+    // OVERWRITE never blocks and runs until the consumer has popped enough
+    while ((stress_cb.policy == CB_OVERWRITE) ? !stress_stop : i < BENCH_STRESS_N) {
+        while (!CB_Push(&stress_cb, &i)) sched_yield();
+        // Still laps the consumer, but keeps the sequence far from wrapping
+        if ((++i & 1023u) == 0 && stress_cb.policy == CB_OVERWRITE) sched_yield();
+    }
+    stress_pushed = i;
+    stress_done = 1;
+    return NULL;
+}
+
+/**
+ * Two threads through CircularBuffer, returns the number of errors.
+ *
+ * The consumer pops BENCH_STRESS_N items in both policies. Sequence numbers
+ * must never repeat or go back, and every gap must be matched by drops.
+ */
+static uint32_t stress_cb_spsc(uint8_t policy) {
+    pthread_t th;
+    uint32_t expect = 0, popped = 0, skipped = 0, errors = 0, v;
+
+    cb_setup(&stress_cb, 4, policy);
+    stress_done = 0;
+    stress_stop = 0;
+    pthread_create(&th, NULL, cb_producer, NULL);
+
+    for (;;) {
+        int done = stress_done;
+        if (CB_Pop(&stress_cb, &v)) {
+            if (v < expect) errors++;
+            else skipped += v - expect;
+            expect = v + 1;
+            if (++popped == BENCH_STRESS_N) stress_stop = 1;
+        } else if (done) {
+            break;
+        } else {
+            sched_yield();
+        }
+    }
+    pthread_join(th, NULL);
+
+    // REJECT must see every item, OVERWRITE may skip but only what it reported as drops
+    if (expect != stress_pushed || popped < BENCH_STRESS_N) errors++;
+    if (policy == CB_REJECT && skipped != 0) errors++;
+    if (policy == CB_OVERWRITE && (skipped != stress_cb.drops || popped + skipped != stress_pushed)) errors++;
+    printf("SPSC CircularBuffer %-9s pushed %u popped %u drops %u errors %u\n",
+           policy == CB_REJECT ? "REJECT" : "OVERWRITE", stress_pushed, popped, (unsigned)skipped, errors);
+    return errors;
+}
+
+static void *typed_producer(void *arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < BENCH_STRESS_N; i++) {
+        while (!StressRing_Push(&stress_typed, &i)) sched_yield();
+    }
+    stress_done = 1;
+    return NULL;
+}
+
+static uint32_t stress_typed_spsc(void) {
+    pthread_t th;
+    uint32_t expect = 0, errors = 0, v;
+
+    StressRing_Init(&stress_typed);
+    stress_done = 0;
+    pthread_create(&th, NULL, typed_producer, NULL);
+
+    for (;;) {
+        int done = stress_done;
+        if (StressRing_Pop(&stress_typed, &v)) {
+            if (v != expect) errors++;
+            expect = v + 1;
+        } else if (done) {
+            break;
+        } else {
+            sched_yield();
+        }
+    }
+    pthread_join(th, NULL);
+
+    if (expect != BENCH_STRESS_N) errors++;
+    printf("SPSC typed ring           popped %u errors %u\n", expect, errors);
+    return errors;
+}
+
+#define STRESS_PRODUCERS 3
+
+static void *mpsc_producer(void *arg) {
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    for (uint32_t i = 0; i < BENCH_STRESS_N / STRESS_PRODUCERS; i++) {
+        uint32_t v = (id << 28) | i;
+        while (!MPSC_Push(&stress_mpsc, &v)) sched_yield();
+    }
+    return NULL;
+}
+
+static uint32_t stress_mpsc_run(void) {
+    static uint32_t storage[MPSC_STORAGE_WORDS(1024, 4)];
+    pthread_t th[STRESS_PRODUCERS];
+    uint32_t expect[STRESS_PRODUCERS] = { 0 };
+    uint32_t per = BENCH_STRESS_N / STRESS_PRODUCERS;
+    uint32_t left = per * STRESS_PRODUCERS, errors = 0, v;
+
+    MPSC_Init(&stress_mpsc, storage, 1024, 4);
+    for (uint32_t p = 0; p < STRESS_PRODUCERS; p++) {
+        pthread_create(&th[p], NULL, mpsc_producer, (void*)(uintptr_t)p);
+    }
+
+    // Pushes were retried until accepted, so exactly left items must arrive
+    while (left) {
+        if (!MPSC_Pop(&stress_mpsc, &v)) {
+            sched_yield();
+            continue;
+        }
+        uint32_t id = v >> 28;
+        if (id >= STRESS_PRODUCERS || (v & 0x0FFFFFFFu) != expect[id]) errors++;
+        else expect[id]++;
+        left--;
+    }
+    for (uint32_t p = 0; p < STRESS_PRODUCERS; p++) pthread_join(th[p], NULL);
+
+    if (MPSC_Pop(&stress_mpsc, &v)) errors++;
+    printf("MPSC %u producers          popped %u errors %u\n", STRESS_PRODUCERS, per * STRESS_PRODUCERS, errors);
+    return errors;
+}
+
+int main(int argc, char **argv) {
+    uint32_t errors = 0;
+    if (argc > 1) iterations = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (iterations < 4096) iterations = 4096;
+
+    printf("--- CircularBuffer (%u iterations)\n", iterations);
+    for (uint8_t i = 0; i < sizeof(item_sizes); i++) bench_cb_push_pop(item_sizes[i]);
+    for (uint8_t i = 0; i < sizeof(item_sizes); i++) bench_cb_bulk(item_sizes[i]);
+    for (uint8_t i = 0; i < sizeof(item_sizes); i++) bench_cb_span(item_sizes[i]);
+    bench_cb_analytics();
+
+    printf("--- Other rings\n");
+    BENCH_TYPED(Ring1, 1);
+    BENCH_TYPED(Ring4, 4);
+    BENCH_TYPED(Ring12, 12);
+    BENCH_TYPED(Ring64, 64);
+    for (uint8_t i = 0; i < sizeof(item_sizes); i++) bench_mpsc(item_sizes[i]);
+    bench_timed();
+
+    printf("--- Window statistics and filters\n");
+    bench_filters();
+
+    printf("--- Stress\n");
+    errors += stress_cb_spsc(CB_REJECT);
+    errors += stress_cb_spsc(CB_OVERWRITE);
+    errors += stress_typed_spsc();
+    errors += stress_mpsc_run();
+
+    printf("%s\n", errors ? "FAILED" : "PASSED");
+    return errors ? 1 : 0;
+}
+
+#endif // __linux__
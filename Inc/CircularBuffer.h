@@ -2,9 +2,17 @@
  * @file CircularBuffer.h
  * @brief Generic circular buffer
  *
+ * Push and Pop are safe for one producer and one consumer running in different
+ * contexts (e.g. UART ISR and a task): the producer only writes @c tail, the
+ * consumer only writes @c head and both are ordered with memory barriers.
+ *
+ * Storage comes from the heap (CB_Init), from the caller (CB_InitStatic) or
+ * from a fixed-block pool (CB_InitPool). Define CB_NO_HEAP to build without
+ * malloc/free.
+ *
  * @author [Crypto Schizo]
  * @date [15.05.2025]
- * @version 1.1
+ * @version 1.2
  */
 
 #ifndef CIRCULAR_BUFFER_H
@@ -13,41 +21,124 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+/**
+ * @brief Behaviour of CB_Push when the buffer is full.
+ */
+typedef enum {
+	CB_OVERWRITE = 0,      /**< Oldest elements are lost, the new one is stored (default). */
+	CB_REJECT              /**< The new element is dropped, stored ones are kept. */
+} CB_FullPolicy;
+
+/**
+ * @brief Origin of the buffer memory, decides what CB_Free does.
+ */
+typedef enum {
+	CB_STORAGE_HEAP = 0,   /**< Allocated by CB_Init, released with free(). */
+	CB_STORAGE_STATIC,     /**< Provided by the caller, never released. */
+	CB_STORAGE_POOL        /**< Block taken from a CB_Pool, returned to it. */
+} CB_Storage;
+
+/**
+ * @brief Fixed-block pool for rings created at runtime without the heap.
+ *
+ * Free blocks are chained through their first word, so blocks must be at
+ * least pointer-sized and pointer-aligned. Pool calls are not reentrant.
+ */
+typedef struct {
+	void *free_list;       /**< First free block. */
+	uint16_t block_size;   /**< Size of one block in bytes. */
+	uint16_t free_count;   /**< Number of blocks left. */
+} CB_Pool;
+
 /**
  * @brief Circular buffer structure for generic data types.
+ *
+ * @c head and @c tail are running indices wrapping at (size << 24), the slot
+ * is index % size. One slot is kept free, so the capacity is size - 1.
  */
 typedef struct {
 	void *data;            /**< Pointer to the buffer memory. */
 	uint8_t size;          /**< Maximum number of elements in the buffer. */
 	uint8_t item_size;   	/**< Size of a single element in bytes. */
-	uint8_t head;          /**< Index of the oldest element. */
-	uint8_t tail;          /**< Index of the next free position. */
+	uint8_t policy;        /**< CB_FullPolicy applied when the buffer is full. */
+	uint8_t high_water;    /**< Highest fill level observed by the producer. */
+	uint8_t storage;       /**< CB_Storage of the data memory. */
+	volatile uint32_t head;  /**< Running index of the oldest element (consumer-owned). */
+	volatile uint32_t tail;  /**< Running index of the next free position (producer-owned). */
+	volatile uint32_t drops; /**< Elements lost: rejected (CB_REJECT) or overwritten before Pop (CB_OVERWRITE). */
+	CB_Pool *pool;         /**< Pool owning the data block (CB_STORAGE_POOL only). */
 } CircularBuffer;
 
+/**
+ * @brief Contiguous region of elements inside the buffer memory.
+ */
+typedef struct {
+	void *ptr;             /**< First element of the region. */
+	uint32_t count;        /**< Number of elements in the region. */
+} CB_Span;
+
+#ifndef CB_NO_HEAP
 /**
  * @brief Create a circular buffer.
  *
+ * @note size, item_size and policy must be set before the call.
+ *
  * @param buffer Pointer to buffer structure.
  */
 void CB_Init(CircularBuffer *buffer);
+#endif
 
 /**
- * @brief Free the memory allocated for the circular buffer.
+ * @brief Create a circular buffer on caller-provided memory.
+ *
+ * @note size, item_size and policy must be set before the call.
+ *
+ * @param buffer Pointer to buffer structure.
+ * @param storage Memory of at least size * item_size bytes.
+ */
+void CB_InitStatic(CircularBuffer *buffer, void *storage);
+
+/**
+ * @brief Create a circular buffer on a block taken from a pool.
+ *
+ * @note size, item_size and policy must be set before the call.
+ *
+ * @param buffer Pointer to buffer structure.
+ * @param pool Pool to take the block from.
+ * @return uint8_t 1 on success, 0 if the pool is empty or its blocks are too small.
+ */
+uint8_t CB_InitPool(CircularBuffer *buffer, CB_Pool *pool);
+
+/**
+ * @brief Release the buffer memory according to its origin.
+ *
+ * The structure itself is not freed, so it may be embedded in other structs.
  *
  * @param buffer Pointer to the buffer.
  */
 void CB_Free(CircularBuffer *buffer);
 
 /**
- * @brief Push an item to the circular buffer.
+ * @brief Build a pool over caller-provided memory.
+ *
+ * @param pool Pointer to the pool.
+ * @param storage Memory of block_size * count bytes, pointer-aligned.
+ * @param block_size Size of one block in bytes, a multiple of the pointer size.
+ * @param count Number of blocks.
+ */
+void CB_PoolInit(CB_Pool *pool, void *storage, uint16_t block_size, uint16_t count);
+
+/**
+ * @brief Push an item to the circular buffer (producer side).
  *
  * @param buffer Pointer to the buffer.
  * @param item Pointer to the item to add.
+ * @return uint8_t 1 if stored, 0 if rejected because the buffer is full.
  */
-void CB_Push(CircularBuffer *buffer, const void *item);
+uint8_t CB_Push(CircularBuffer *buffer, const void *item);
 
 /**
- * @brief Pop an item from the circular buffer.
+ * @brief Pop an item from the circular buffer (consumer side).
  *
  * @param buffer Pointer to the buffer.
  * @param item Pointer to store the popped item.
@@ -55,6 +146,104 @@ void CB_Push(CircularBuffer *buffer, const void *item);
  */
 uint8_t CB_Pop(CircularBuffer *buffer, void *item);
 
+/**
+ * @brief Push up to n items with at most two block copies (producer side).
+ *
+ * With CB_REJECT only the items that fit are stored and the rest are counted
+ * in drops. With CB_OVERWRITE all items are accepted.
+ *
+ * @param buffer Pointer to the buffer.
+ * @param items Pointer to the first item.
+ * @param n Number of items.
+ * @return uint32_t Number of items stored.
+ */
+uint32_t CB_PushN(CircularBuffer *buffer, const void *items, uint32_t n);
+
+/**
+ * @brief Pop up to n items with at most two block copies (consumer side).
+ *
+ * @param buffer Pointer to the buffer.
+ * @param items Pointer to store the popped items.
+ * @param n Maximum number of items.
+ * @return uint32_t Number of items popped.
+ */
+uint32_t CB_PopN(CircularBuffer *buffer, void *items, uint32_t n);
+
+/**
+ * @brief Get the free space as up to two regions to fill in place (producer side).
+ *
+ * Only free slots are returned, whatever the policy, so unread elements are
+ * never handed out. Publish the written elements with CB_Commit.
+ *
+ * @param buffer Pointer to the buffer.
+ * @param span Array of two regions; span[1] is used when the free space wraps.
+ * @return uint32_t Total number of free slots.
+ */
+uint32_t CB_Reserve(CircularBuffer *buffer, CB_Span span[2]);
+
+/**
+ * @brief Publish n elements written into the regions returned by CB_Reserve.
+ *
+ * @param buffer Pointer to the buffer.
+ * @param n Number of elements written, at most the value returned by CB_Reserve.
+ */
+void CB_Commit(CircularBuffer *buffer, uint32_t n);
+
+/**
+ * @brief Get the stored elements as up to two regions to read in place (consumer side).
+ *
+ * Release the elements with CB_Consume.
+ *
+ * @param buffer Pointer to the buffer.
+ * @param span Array of two regions, oldest elements first.
+ * @return uint32_t Total number of readable elements.
+ */
+uint32_t CB_Peek(CircularBuffer *buffer, CB_Span span[2]);
+
+/**
+ * @brief Release n elements returned by CB_Peek.
+ *
+ * @param buffer Pointer to the buffer.
+ * @param n Number of elements to release.
+ * @return uint8_t 1 if the peeked data stayed intact, 0 if the producer
+ *         overwrote part of it meanwhile (CB_OVERWRITE only).
+ */
+uint8_t CB_Consume(CircularBuffer *buffer, uint32_t n);
+
+/**
+ * @brief Get the stored elements as up to two read-only regions, oldest first.
+ *
+ * Unlike CB_Peek nothing is modified, so it can be used for analytics over
+ * the live window, e.g. through CB_FOREACH.
+ *
+ * @param buffer Pointer to the buffer.
+ * @param span Array of two regions; span[1].count is 0 when the data does not wrap.
+ * @return uint32_t Total number of elements.
+ */
+uint32_t CB_View(const CircularBuffer *buffer, CB_Span span[2]);
+
+/**
+ * @brief Iterate over the stored elements, oldest first, without modulo or callbacks.
+ *
+ * @code
+ * CB_FOREACH(&accel, int16_t, s) { peak = (*s > peak) ? *s : peak; }
+ * @endcode
+ *
+ * @note @c break only leaves the current region.
+ */
+#define CB_FOREACH(buffer, type, var)                                                         \
+	for (CB_Span cb_span_[2], *cb_seg_ = (CB_View((buffer), cb_span_), cb_span_);             \
+			cb_seg_ < cb_span_ + 2; cb_seg_++)                                                \
+		for (type *var = (type*)cb_seg_->ptr, *cb_end_ = var + cb_seg_->count; var < cb_end_; var++)
+
+/**
+ * @brief Get the number of elements currently stored.
+ *
+ * @param buffer Pointer to the buffer.
+ * @return uint32_t Number of elements, at most size - 1.
+ */
+uint32_t CB_Count(const CircularBuffer *buffer);
+
 /**
  * @brief Calculate the maximum difference between consecutive elements.
  *
@@ -0,0 +1,139 @@
+/**
+ * @file CircularBufferTyped.h
+ * @brief Statically typed power-of-two circular buffers generated at compile time
+ *
+ * CB_DEFINE(name, type, log2size) declares the ring type @c name_t and the
+ * inline functions name_Init, name_Count, name_Push, name_PushOverwrite,
+ * name_Pop, name_Peek, name_Consume, name_View and name_At. Indices are free-running
+ * 32-bit counters masked with (size - 1), so there is no division and all
+ * 2^log2size slots are usable. Elements are copied with a fixed-size memcpy the
+ * compiler inlines. Wrap arrays in a struct: a bare array @c type makes every
+ * const item pointer a pointer to a const-qualified array, which ISO C before
+ * C2X rejects (-Wpedantic).
+ *
+ * Push and Pop follow the same single-producer/single-consumer rules as
+ * CircularBuffer: the producer writes only @c tail, the consumer only @c head.
+ *
+ * @code
+ * typedef struct { int16_t xyz[3]; } AccelSample;
+ * CB_DEFINE(AccelRing, AccelSample, 11)   // 2048 samples
+ * static AccelRing_t accel;
+ * AccelRing_Push(&accel, &sample);
+ *
+ * AccelSample *s;
+ * while ((s = AccelRing_Peek(&accel)) != NULL) {
+ *     process(s);
+ *     AccelRing_Consume(&accel, 1);
+ * }
+ * @endcode
+ *
+ * @author [Nate Hunter]
+ * @date [16.10.2026]
+ * @version 1.0
+ */
+
+#ifndef CIRCULAR_BUFFER_TYPED_H
+#define CIRCULAR_BUFFER_TYPED_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define CB_DEFINE(name, type, log2size)                                                     \
+_Static_assert((log2size) > 0 && (log2size) < 31, #name ": log2size out of range");         \
+typedef __typeof__(type) name##_item_t;                                                     \
+                                                                                            \
+/** Typed ring of 2^log2size elements. */                                                   \
+typedef struct {                                                                            \
+	name##_item_t data[1u << (log2size)]; /**< Element storage. */                          \
+	volatile uint32_t head;               /**< Running index of the oldest element. */      \
+	volatile uint32_t tail;               /**< Running index of the next free slot. */      \
+	volatile uint32_t drops;              /**< Elements rejected because the ring was full. */ \
+} name##_t;                                                                                 \
+                                                                                            \
+enum { name##_SIZE = 1u << (log2size), name##_MASK = (1u << (log2size)) - 1u };             \
+                                                                                            \
+static inline void name##_Init(name##_t *cb) {                                              \
+	cb->head = 0;                                                                           \
+	cb->tail = 0;                                                                           \
+	cb->drops = 0;                                                                          \
+}                                                                                           \
+                                                                                            \
+static inline uint32_t name##_Count(const name##_t *cb) {                                   \
+	return cb->tail - cb->head;                                                             \
+}                                                                                           \
+                                                                                            \
+/* Producer side. Returns 0 and counts a drop when the ring is full. */                     \
+static inline uint8_t name##_Push(name##_t *cb, const name##_item_t *item) {                \
+	uint32_t tail = cb->tail;                                                               \
+	if (tail - cb->head >= name##_SIZE) {                                                   \
+		cb->drops++;                                                                        \
+		return 0;                                                                           \
+	}                                                                                       \
+	atomic_thread_fence(memory_order_acquire);                                              \
+	memcpy(&cb->data[tail & name##_MASK], item, sizeof(name##_item_t));                     \
+	atomic_thread_fence(memory_order_release);                                              \
+	cb->tail = tail + 1;                                                                    \
+	return 1;                                                                               \
+}                                                                                           \
+                                                                                            \
+/* Single-context push that drops the oldest element when full (moves head). */             \
+static inline void name##_PushOverwrite(name##_t *cb, const name##_item_t *item) {          \
+	uint32_t tail = cb->tail;                                                               \
+	memcpy(&cb->data[tail & name##_MASK], item, sizeof(name##_item_t));                     \
+	cb->tail = tail + 1;                                                                    \
+	if (tail + 1 - cb->head > name##_SIZE) {                                                \
+		cb->head = tail + 1 - name##_SIZE;                                                  \
+	}                                                                                       \
+}                                                                                           \
+                                                                                            \
+/* Consumer side. Returns 0 when the ring is empty. */                                      \
+static inline uint8_t name##_Pop(name##_t *cb, name##_item_t *item) {                       \
+	uint32_t head = cb->head;                                                               \
+	if (cb->tail == head) {                                                                 \
+		return 0;                                                                           \
+	}                                                                                       \
+	atomic_thread_fence(memory_order_acquire);                                              \
+	memcpy(item, &cb->data[head & name##_MASK], sizeof(name##_item_t));                     \
+	atomic_thread_fence(memory_order_release);                                              \
+	cb->head = head + 1;                                                                    \
+	return 1;                                                                               \
+}                                                                                           \
+                                                                                            \
+/* Consumer side. Pointer to the oldest element or NULL when empty. */                      \
+static inline name##_item_t *name##_Peek(name##_t *cb) {                                    \
+	uint32_t head = cb->head;                                                               \
+	if (cb->tail == head) {                                                                 \
+		return NULL;                                                                        \
+	}                                                                                       \
+	atomic_thread_fence(memory_order_acquire);                                              \
+	return &cb->data[head & name##_MASK];                                                   \
+}                                                                                           \
+                                                                                            \
+/* Consumer side. Release n elements read through Peek, View or At, n <= Count. */          \
+static inline void name##_Consume(name##_t *cb, uint32_t n) {                               \
+	uint32_t head = cb->head;                                                               \
+	atomic_thread_fence(memory_order_release);                                              \
+	cb->head = head + n;                                                                    \
+}                                                                                           \
+                                                                                            \
+/* Stored elements as up to two contiguous regions, oldest first. */                        \
+static inline uint32_t name##_View(name##_t *cb, name##_item_t *seg[2], uint32_t len[2]) {  \
+	uint32_t head = cb->head;                                                               \
+	uint32_t count = cb->tail - head;                                                       \
+	uint32_t first = name##_SIZE - (head & name##_MASK);                                    \
+	atomic_thread_fence(memory_order_acquire);                                              \
+	if (first > count) first = count;                                                       \
+	seg[0] = &cb->data[head & name##_MASK];                                                 \
+	len[0] = first;                                                                         \
+	seg[1] = cb->data;                                                                      \
+	len[1] = count - first;                                                                 \
+	return count;                                                                           \
+}                                                                                           \
+                                                                                            \
+/* i-th oldest element, i < name_Count() is not checked. */                                 \
+static inline name##_item_t *name##_At(name##_t *cb, uint32_t i) {                          \
+	return &cb->data[(cb->head + i) & name##_MASK];                                         \
+}
+
+#endif // CIRCULAR_BUFFER_TYPED_H
@@ -0,0 +1,109 @@
+/**
+ * @file CircularStats.h
+ * @brief Sliding window of samples with O(1) running statistics
+ *
+ * Every push updates the running sum, sum of squares and three monotonic
+ * deques (min, max and max absolute delta between consecutive samples), so
+ * mean, variance, min, max and max delta are read in constant time.
+ *
+ * Statistics are exact while size * max(|x|)^2 fits in the 64-bit sum of
+ * squares, e.g. any window of up to 65535 samples within +-2^24. The variance
+ * never forms n * sum_sq, so it needs no further headroom.
+ *
+ * @author [Nate Hunter]
+ * @date [16.10.2026]
+ * @version 1.0
+ */
+
+#ifndef CIRCULAR_STATS_H
+#define CIRCULAR_STATS_H
+
+#include <stdint.h>
+
+/** @def CBS_STORAGE_WORDS
+ * @brief Number of uint32_t words of storage needed for a window of n samples.
+ */
+#define CBS_STORAGE_WORDS(n) (((uint32_t)(n) * 10u + 3u) / 4u)
+
+/**
+ * @brief Monotonic deque of window slots, kept in push order.
+ */
+typedef struct {
+	uint16_t *slot;        /**< Ring of window slot indices. */
+	uint16_t head;         /**< Position of the oldest entry. */
+	uint16_t count;        /**< Number of entries. */
+} CBS_Deque;
+
+/**
+ * @brief Sliding window with incremental statistics.
+ */
+typedef struct {
+	int32_t *samples;      /**< Window ring of size samples. */
+	uint16_t size;         /**< Window length in samples. */
+	uint16_t oldest;       /**< Slot of the oldest sample. */
+	uint16_t count;        /**< Number of samples in the window. */
+	int64_t sum;           /**< Sum of the samples in the window. */
+	uint64_t sum_sq;       /**< Sum of the squared samples in the window. */
+	CBS_Deque min;         /**< Slots with increasing values, front is the minimum. */
+	CBS_Deque max;         /**< Slots with decreasing values, front is the maximum. */
+	CBS_Deque delta;       /**< Slots with decreasing |x[s] - x[s-1]|, front is the max delta. */
+} CBS_Window;
+
+/**
+ * @brief Initialize an empty window.
+ *
+ * @param w Pointer to the window.
+ * @param storage Memory of CBS_STORAGE_WORDS(size) words.
+ * @param size Window length in samples (1..65535).
+ */
+void CBS_Init(CBS_Window *w, uint32_t *storage, uint16_t size);
+
+/**
+ * @brief Add a sample, evicting the oldest one when the window is full.
+ *
+ * @param w Pointer to the window.
+ * @param x New sample.
+ */
+void CBS_Push(CBS_Window *w, int32_t x);
+
+/**
+ * @brief Arithmetic mean of the window, 0 when empty.
+ *
+ * @param w Pointer to the window.
+ * @return float Mean value.
+ */
+float CBS_Mean(const CBS_Window *w);
+
+/**
+ * @brief Population variance of the window, 0 when empty.
+ *
+ * @param w Pointer to the window.
+ * @return float Variance.
+ */
+float CBS_Variance(const CBS_Window *w);
+
+/**
+ * @brief Smallest sample in the window, 0 when empty.
+ *
+ * @param w Pointer to the window.
+ * @return int32_t Minimum.
+ */
+int32_t CBS_Min(const CBS_Window *w);
+
+/**
+ * @brief Largest sample in the window, 0 when empty.
+ *
+ * @param w Pointer to the window.
+ * @return int32_t Maximum.
+ */
+int32_t CBS_Max(const CBS_Window *w);
+
+/**
+ * @brief Largest absolute difference between consecutive samples, 0 if fewer than two.
+ *
+ * @param w Pointer to the window.
+ * @return uint32_t Maximum delta.
+ */
+uint32_t CBS_MaxDelta(const CBS_Window *w);
+
+#endif // CIRCULAR_STATS_H
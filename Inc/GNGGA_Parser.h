@@ -49,6 +49,7 @@ typedef enum {
 typedef struct {
     UART_HandleTypeDef *huart;
     CircularBuffer rxBuf;
+    uint8_t rxStorage[GNGGA_BUFFER_CAPACITY];
     uint8_t rxData;
 
     GNGGA_State state;
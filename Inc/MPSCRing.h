@@ -0,0 +1,109 @@
+/**
+ * @file MPSCRing.h
+ * @brief Lock-free multi-producer/single-consumer ring for event fan-in
+ *
+ * Producers (tasks and ISRs) reserve a slot with a compare-and-swap on the
+ * reservation counter (LDREX/STREX on Cortex-M3 and up, C11 atomics on host),
+ * fill it and publish it by writing the slot sequence number. No critical
+ * section or kernel call is needed, so ISRs can post directly.
+ *
+ * Slots are consumed in reservation order: a producer preempted between
+ * reserve and commit holds back later slots until it commits, the consumer
+ * then simply sees the ring as empty for a while.
+ *
+ * @author [Nate Hunter]
+ * @date [16.10.2026]
+ * @version 1.0
+ */
+
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+/** @def MPSC_STRIDE
+ * @brief Bytes per slot: sequence word plus the item rounded up to a word.
+ */
+#define MPSC_STRIDE(item_size) (4u + (((uint32_t)(item_size) + 3u) & ~3u))
+
+/** @def MPSC_STORAGE_WORDS
+ * @brief Number of uint32_t words of storage for n slots of item_size bytes.
+ */
+#define MPSC_STORAGE_WORDS(n, item_size) ((uint32_t)(n) * MPSC_STRIDE(item_size) / 4u)
+
+/**
+ * @brief Multi-producer/single-consumer ring.
+ */
+typedef struct {
+	uint8_t *slots;        /**< Slot storage, each slot is [seq][item]. */
+	uint32_t mask;         /**< Number of slots - 1 (power of two). */
+	uint16_t item_size;    /**< Size of one item in bytes. */
+	uint16_t stride;       /**< Size of one slot in bytes. */
+	_Atomic uint32_t tail; /**< Next position to reserve (shared by producers). */
+	uint32_t head;         /**< Next position to consume (consumer-owned). */
+	_Atomic uint32_t drops; /**< Items rejected because the ring was full. */
+} MPSC_Ring;
+
+/**
+ * @brief Initialize the ring over caller-provided storage.
+ *
+ * @param r Pointer to the ring.
+ * @param storage MPSC_STORAGE_WORDS(slots, item_size) words.
+ * @param slots Number of slots, a power of two, at least 2.
+ * @param item_size Size of one item in bytes.
+ * @return uint8_t 1 on success, 0 if @p slots is not a power of two >= 2.
+ */
+uint8_t MPSC_Init(MPSC_Ring *r, uint32_t *storage, uint32_t slots, uint16_t item_size);
+
+/**
+ * @brief Reserve a slot to fill in place (any producer, ISR-safe).
+ *
+ * @param r Pointer to the ring.
+ * @param ticket Receives the position to pass to MPSC_Commit.
+ * @return void* Item memory, NULL if the ring is full (counted in drops).
+ */
+void *MPSC_Reserve(MPSC_Ring *r, uint32_t *ticket);
+
+/**
+ * @brief Publish a slot obtained with MPSC_Reserve.
+ *
+ * @param r Pointer to the ring.
+ * @param ticket Position returned by MPSC_Reserve.
+ */
+void MPSC_Commit(MPSC_Ring *r, uint32_t ticket);
+
+/**
+ * @brief Copy an item into the ring (any producer, ISR-safe).
+ *
+ * @param r Pointer to the ring.
+ * @param item Pointer to the item.
+ * @return uint8_t 1 if queued, 0 if the ring is full.
+ */
+uint8_t MPSC_Push(MPSC_Ring *r, const void *item);
+
+/**
+ * @brief Get the oldest published item in place (consumer only).
+ *
+ * @param r Pointer to the ring.
+ * @return void* Item memory, NULL if nothing is published yet.
+ */
+void *MPSC_Peek(MPSC_Ring *r);
+
+/**
+ * @brief Release the item returned by MPSC_Peek (consumer only).
+ *
+ * @param r Pointer to the ring.
+ */
+void MPSC_Release(MPSC_Ring *r);
+
+/**
+ * @brief Copy the oldest published item out of the ring (consumer only).
+ *
+ * @param r Pointer to the ring.
+ * @param item Pointer to store the item.
+ * @return uint8_t 1 if an item was popped, 0 if none is published.
+ */
+uint8_t MPSC_Pop(MPSC_Ring *r, void *item);
+
+#endif // MPSC_RING_H
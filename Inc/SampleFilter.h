@@ -0,0 +1,123 @@
+/**
+ * @file SampleFilter.h
+ * @brief Windowed filter kernels for sensor sample streams
+ *
+ * Moving average, exponential moving average, running median and decimating
+ * FIR filters in int16_t (_i16), int32_t (_i32) and float (_f32) versions,
+ * e.g. SF_MA_Push_i16() or SF_Median_Push_f32(). All storage is provided by
+ * the caller. Per-sample cost does not depend on the window length except
+ * for the median (O(log n)) and the FIR output step (one dot product every
+ * decim samples).
+ *
+ * Integer FIR coefficients are Q15 (int16_t), float ones are float. The
+ * window is kept contiguous (history of 2 * taps samples), so the dot
+ * product is a plain linear loop that auto-vectorises on host and uses the
+ * SMLALD dual MAC on Cortex-M4/M7. coeffs[0] weights the oldest sample.
+ *
+ * @author [Nate Hunter]
+ * @date [16.10.2026]
+ * @version 1.0
+ */
+
+#ifndef SAMPLE_FILTER_H
+#define SAMPLE_FILTER_H
+
+#include <stdint.h>
+
+/** @def SF_FIR_Q
+ * @brief Fraction bits of the integer FIR coefficients.
+ */
+#define SF_FIR_Q 15
+
+/** @def SF_MEDIAN_MAX_SIZE
+ * @brief Longest running median window, its heap slots are stored as int16_t.
+ */
+#define SF_MEDIAN_MAX_SIZE 32767
+
+/**
+ * @brief Declare the filter types and functions for one sample type.
+ *
+ * - SF_MA_Init(f, buf, size) / SF_MA_Push(f, x): mean of the last size samples.
+ *   Init returns 0 if size is 0.
+ * - SF_EMA_Init(f, shift|alpha) / SF_EMA_Push(f, x): exponential average.
+ * - SF_Median_Init(f, data, index, size) / SF_Median_Push(f, x): median of the
+ *   last size samples; data holds size samples, index 2 * size entries.
+ *   Init returns 0 unless size is 1..SF_MEDIAN_MAX_SIZE.
+ * - SF_FIR_Init(f, coeffs, hist, taps, decim): hist holds 2 * taps samples.
+ * - SF_FIR_Push(f, x, &y): returns 1 and writes y on every decim-th sample.
+ * - SF_FIR_Process(f, in, n, out): block version, returns the number of outputs.
+ *
+ * @param T Sample type.
+ * @param S Name suffix.
+ * @param ACC Accumulator type of the moving average and EMA.
+ * @param COEF FIR coefficient type.
+ */
+#define SF_DECLARE(T, S, ACC, COEF)                                                     \
+/** Moving average over a window of size samples. */                                    \
+typedef struct {                                                                        \
+	T *buf;                /**< Window ring of size samples. */                         \
+	uint16_t size;         /**< Window length. */                                       \
+	uint16_t pos;          /**< Slot of the next sample. */                             \
+	uint16_t count;        /**< Number of samples in the window. */                     \
+	ACC sum;               /**< Running sum of the window. */                           \
+} SF_MA_##S;                                                                            \
+                                                                                        \
+/** Exponential moving average, y += (x - y) * alpha. */                                \
+typedef struct {                                                                        \
+	ACC acc;               /**< Filter state (scaled by 2^shift for integers). */       \
+	float alpha;           /**< Smoothing factor (float version). */                    \
+	uint8_t shift;         /**< alpha = 2^-shift (integer versions). */                 \
+	uint8_t primed;        /**< Set once the first sample has been taken. */            \
+} SF_EMA_##S;                                                                           \
+                                                                                        \
+/** Running median, two heaps around the median sharing one index array. */           \
+typedef struct {                                                                        \
+	T *data;               /**< Window ring of size samples. */                         \
+	int16_t *pos;          /**< Heap position of each window slot. */                   \
+	int16_t *heap;         /**< Window slots, max-heap at < 0, median at 0, min-heap at > 0. */ \
+	uint16_t size;         /**< Window length. */                                       \
+	uint16_t idx;          /**< Slot of the next sample. */                             \
+	uint16_t count;        /**< Number of samples in the window. */                     \
+} SF_Median_##S;                                                                        \
+                                                                                        \
+/** Decimating FIR filter. */                                                           \
+typedef struct {                                                                        \
+	const COEF *coeffs;    /**< taps coefficients, coeffs[0] weights the oldest sample. */ \
+	T *hist;               /**< 2 * taps samples, every sample stored twice. */         \
+	uint16_t taps;         /**< Number of taps. */                                      \
+	uint16_t pos;          /**< Slot of the newest sample. */                           \
+	uint16_t decim;        /**< Decimation factor, 1 for a plain FIR. */                \
+	uint16_t phase;        /**< Samples left until the next output. */                  \
+} SF_FIR_##S;                                                                           \
+                                                                                        \
+uint8_t SF_MA_Init_##S(SF_MA_##S *f, T *buf, uint16_t size);                            \
+T SF_MA_Push_##S(SF_MA_##S *f, T x);                                                    \
+T SF_EMA_Push_##S(SF_EMA_##S *f, T x);                                                  \
+uint8_t SF_Median_Init_##S(SF_Median_##S *f, T *data, int16_t *index, uint16_t size);   \
+T SF_Median_Push_##S(SF_Median_##S *f, T x);                                            \
+void SF_FIR_Init_##S(SF_FIR_##S *f, const COEF *coeffs, T *hist, uint16_t taps, uint16_t decim); \
+uint8_t SF_FIR_Push_##S(SF_FIR_##S *f, T x, T *out);                                    \
+uint32_t SF_FIR_Process_##S(SF_FIR_##S *f, const T *in, uint32_t n, T *out);
+
+SF_DECLARE(int16_t, i16, int32_t, int16_t)
+SF_DECLARE(int32_t, i32, int64_t, int16_t)
+SF_DECLARE(float, f32, float, float)
+
+/**
+ * @brief Initialize an integer EMA with alpha = 2^-shift.
+ *
+ * @param f Pointer to the filter.
+ * @param shift Smoothing shift (0..15).
+ */
+void SF_EMA_Init_i16(SF_EMA_i16 *f, uint8_t shift);
+void SF_EMA_Init_i32(SF_EMA_i32 *f, uint8_t shift);
+
+/**
+ * @brief Initialize a float EMA.
+ *
+ * @param f Pointer to the filter.
+ * @param alpha Smoothing factor in (0, 1].
+ */
+void SF_EMA_Init_f32(SF_EMA_f32 *f, float alpha);
+
+#endif // SAMPLE_FILTER_H
@@ -10,6 +10,44 @@
 #define LOG_SYS_LOG_H_
 
 #include "stdint.h"
+#include "stddef.h"
+
+/** W25Qx flash chip of the flash sink, see W25Qx.h */
+typedef struct W25Qx_Device W25Qx_Device;
+
+/** @def SYS_LOG_BINARY
+ * @brief 1 to record messages as binary records formatted later, 0 to format in the caller.
+ *
+ * Binary records hold the format string pointer, tag pointer, timestamp,
+ * level and the raw argument words. The SWV sink renders them to text, the
+ * UDP and eMMC sinks ship them as is for Tools/syslog_decode.py, which reads
+ * the strings from the firmware ELF. %s arguments must therefore point to
+ * constant strings (literals, tags), not to buffers on the stack. Text
+ * formatted by sys_log_write travels whole, up to MAX_LOG_MESSAGE_SIZE - 1
+ * characters, in the argument words of a record with an empty format.
+ */
+#ifndef SYS_LOG_BINARY
+#define SYS_LOG_BINARY 0
+#endif
+
+/** @def SYS_LOG_TIMESTAMP_US
+ * @brief 1 to stamp messages in microseconds from the DWT cycle counter, 0 for HAL ticks (ms).
+ *
+ * CYCCNT and the HAL tick are extended to 64 bits, so the stamps do not
+ * wrap. Cores or host builds without a DWT fall back to the HAL tick * 1000.
+ * Millisecond stamps (0) wrap with the 32-bit HAL tick, every 49.7 days.
+ */
+#ifndef SYS_LOG_TIMESTAMP_US
+#define SYS_LOG_TIMESTAMP_US 0
+#endif
+
+#if SYS_LOG_TIMESTAMP_US
+typedef unsigned long long sys_log_time_t;
+#define SYS_LOG_TIME_FMT "%llu"
+#else
+typedef unsigned long sys_log_time_t;
+#define SYS_LOG_TIME_FMT "%lu"
+#endif
 
 /** @def LOG_MMC_DIR
  * @brief Directory path for log files on MMC.
@@ -17,30 +55,186 @@
 #define LOG_MMC_DIR "log/"
 
 /** @def LOG_MMC_FILE_FORMAT
- * @brief Format of log filenames.
+ * @brief Format of log filenames, numbered by an ever increasing sequence.
+ */
+#define LOG_MMC_FILE_PREFIX "SYS_log_"
+#if SYS_LOG_BINARY
+#define LOG_MMC_FILE_EXT ".bin"
+#else
+#define LOG_MMC_FILE_EXT ".log"
+#endif
+#define LOG_MMC_FILE_FORMAT LOG_MMC_FILE_PREFIX "%05lu" LOG_MMC_FILE_EXT
+
+/** @def LOG_MMC_PREALLOCATE
+ * @brief Reserve file_size contiguous bytes with f_expand for each new log
+ *        file (needs FF_USE_EXPAND). The file is truncated when it is closed.
+ *
+ * f_expand sets the file size without clearing the clusters, so a file left
+ * open by a power loss ends in whatever those clusters held before: stale
+ * records of deleted logs, not zeros. Tools/syslog_decode.py stops each file
+ * at the first invalid record; text logs must be cut after the last line
+ * with a current timestamp.
+ */
+#ifndef LOG_MMC_PREALLOCATE
+#define LOG_MMC_PREALLOCATE 0
+#endif
+
+/** @def LOG_MMC_BUFFER_SIZE
+ * @brief Write-behind buffer of the eMMC sink, a multiple of the 512-byte sector.
+ */
+#ifndef LOG_MMC_BUFFER_SIZE
+#define LOG_MMC_BUFFER_SIZE 2048
+#endif
+
+/** @def LOG_MMC_FLUSH_MS
+ * @brief Longest time a message waits in the eMMC buffer before it is written.
  */
-#define LOG_MMC_FILE_FORMAT "SYS_log_%03u.log"
+#ifndef LOG_MMC_FLUSH_MS
+#define LOG_MMC_FLUSH_MS 1000
+#endif
+
+/** @def LOG_MMC_RETRY_MS
+ * @brief Delay before the eMMC sink tries again to open a log file; messages
+ *        wait in the log arena meanwhile.
+ */
+#ifndef LOG_MMC_RETRY_MS
+#define LOG_MMC_RETRY_MS 1000
+#endif
 
 /** @def LOG_UDP_PORT
  * @brief UDP port for log output.
  */
 #define LOG_UDP_PORT 20101
 
+/** @def LOG_UDP_DATAGRAM_SIZE
+ * @brief Largest UDP log datagram including its header, keep it below the path MTU.
+ */
+#ifndef LOG_UDP_DATAGRAM_SIZE
+#define LOG_UDP_DATAGRAM_SIZE 1400
+#endif
+
+/** @def LOG_UDP_FLUSH_MS
+ * @brief Longest time a message waits for more to share its datagram.
+ */
+#ifndef LOG_UDP_FLUSH_MS
+#define LOG_UDP_FLUSH_MS 20
+#endif
+
+/** @def SYS_LOG_UDP_MAGIC
+ * @brief First field of every UDP log datagram.
+ */
+#define SYS_LOG_UDP_MAGIC 0x4C53u
+#define SYS_LOG_UDP_VERSION 1u
+#define SYS_LOG_UDP_BINARY 0x01u   /*!< Flag: payload holds binary records instead of text lines */
+
+/** @def LOG_ITM_PORT
+ * @brief ITM stimulus port of a level: ERROR on port 1 up to VERBOSE on port 5.
+ *
+ * Port 0 is left to printf-style output and the logger's own diagnostics.
+ * Enable the ports in the trace configuration to receive their levels.
+ */
+#ifndef LOG_ITM_PORT
+#define LOG_ITM_PORT(level) (level)
+#endif
+
+/** @def LOG_ITM_SPIN
+ * @brief Polls of a full stimulus port FIFO before the rest of a message is dropped.
+ */
+#ifndef LOG_ITM_SPIN
+#define LOG_ITM_SPIN 10000
+#endif
+
 /** @def MAX_LOG_MESSAGE_SIZE
  * @brief Maximum characters per log message.
  */
 #define MAX_LOG_MESSAGE_SIZE 128
 
-/** @def LOG_QUEUE_LENGTH
- * @brief Maximum size of the log message queue.
+/** @def LOG_ARENA_SIZE
+ * @brief Bytes of the record arena shared by all sinks, a power of two.
+ *
+ * Each message is stored once with an 8-byte header and read in place by
+ * every enabled sink; its space is reused once the slowest sink is done.
+ */
+#ifndef LOG_ARENA_SIZE
+#define LOG_ARENA_SIZE 8192
+#endif
+
+/** @def LOG_FLASH_FLUSH_MS
+ * @brief Longest time a message waits before its partly filled flash page is programmed.
+ */
+#ifndef LOG_FLASH_FLUSH_MS
+#define LOG_FLASH_FLUSH_MS 1000
+#endif
+
+/** @def LOG_FLASH_ERASE_AHEAD
+ * @brief Sectors the flash sink keeps erased ahead of its write head, erasing while idle.
+ */
+#ifndef LOG_FLASH_ERASE_AHEAD
+#define LOG_FLASH_ERASE_AHEAD 2
+#endif
+
+/** @def SYS_LOG_FLASH_MAGIC
+ * @brief First field of every programmed flash log page.
  */
-#define LOG_QUEUE_LENGTH MAX_LOG_MESSAGE_SIZE * 4
+#define SYS_LOG_FLASH_MAGIC 0x4C46u
 
 /** @def LOG_LOCAL_LEVEL
- * @brief Default log level for local messages.
+ * @brief Highest level compiled in; define it before including this header
+ *        to keep e.g. DEBUG messages of a driver available at runtime.
  */
+#ifndef LOG_LOCAL_LEVEL
 #define LOG_LOCAL_LEVEL SYS_LOG_INFO
+#endif
+
+/** @def LOG_DEFAULT_LEVEL
+ * @brief Runtime level of tags without their own, see SYS_LOG_SetLevel().
+ */
+#ifndef LOG_DEFAULT_LEVEL
+#define LOG_DEFAULT_LEVEL SYS_LOG_INFO
+#endif
+
+/** @def LOG_TAG_BITS
+ * @brief The table of per-tag levels has 2^LOG_TAG_BITS slots.
+ */
+#ifndef LOG_TAG_BITS
+#define LOG_TAG_BITS 4
+#endif
+#define LOG_TAG_SLOTS (1u << LOG_TAG_BITS)
+
+/** @def LOG_DROP_REPORT_MS
+ * @brief Minimum interval between two "messages dropped" summary records.
+ */
+#define LOG_DROP_REPORT_MS 1000
+
+/** @def SYS_LOG_ISR
+ * @brief Flag OR-ed into the level by SYS_LOG_FROM_ISR: never waits, uses ISR-safe calls.
+ */
+#define SYS_LOG_ISR 0x80u
+
+/** @def SYS_LOG_BIN_MAGIC
+ * @brief First half-word of every binary record, used to resync a stream.
+ *        Records with a 64-bit microsecond timestamp use their own value.
+ */
+#if SYS_LOG_TIMESTAMP_US
+#define SYS_LOG_BIN_MAGIC 0xB10Du
+#else
+#define SYS_LOG_BIN_MAGIC 0xB10Cu
+#endif
 
+/** @def SYS_LOG_BIN_MAX_ARGS
+ * @brief Maximum number of arguments of a binary log call.
+ */
+#define SYS_LOG_BIN_MAX_ARGS 8
+
+/** @def SYS_LOG_BIN_MAX_WORDS
+ * @brief Maximum number of argument words, 64-bit and double arguments take two.
+ */
+#define SYS_LOG_BIN_MAX_WORDS (SYS_LOG_BIN_MAX_ARGS * 2)
+
+/** @def SYS_LOG_BIN_TEXT_WORDS
+ * @brief Maximum number of words of a record carrying text from sys_log_write.
+ */
+#define SYS_LOG_BIN_TEXT_WORDS ((MAX_LOG_MESSAGE_SIZE + 3) / 4)
 
 /**
  * @brief Enumeration for log levels.
@@ -54,6 +248,17 @@ typedef enum {
     SYS_LOG_VERBOSE   /*!< Frequent messages for detailed debugging */
 } sys_log_level_t;
 
+/**
+ * @brief Log outputs.
+ */
+typedef enum {
+    SYS_LOG_SINK_SWV,     /*!< ITM/SWV trace */
+    SYS_LOG_SINK_UDP,     /*!< UDP multicast */
+    SYS_LOG_SINK_MMC,     /*!< Files on the eMMC */
+    SYS_LOG_SINK_FLASH,   /*!< Circular region of a W25Qx SPI flash */
+    SYS_LOG_SINK_COUNT
+} sys_log_sink_t;
+
 /**
  * @brief Structure for log settings.
  */
@@ -63,8 +268,75 @@ typedef struct {
     uint8_t log_udp;       /*!< Toggle UDP output */
     uint32_t max_files;    /*!< Maximum number of eMMC files */
     uint32_t file_size;    /*!< Maximum size of one eMMC file */
+    uint8_t non_blocking;  /*!< Drop messages instead of waiting when the log arena is full */
+    uint32_t sync_interval; /*!< Minimum ms between two f_sync of the eMMC log file, 0 syncs after every write */
+    uint16_t node_id;      /*!< Sender ID in UDP datagram headers */
+    uint8_t log_flash;     /*!< Toggle W25Qx flash output */
+    W25Qx_Device *flash;   /*!< Flash chip of the flash sink, set up with W25Qx_Init() */
+    uint32_t flash_base;   /*!< Start of the flash log region, sector aligned */
+    uint32_t flash_size;   /*!< Size of the flash log region, at least LOG_FLASH_ERASE_AHEAD + 2 sectors */
 } sys_log_settings_t;
 
+/**
+ * @brief Header of a flash log page, followed by up to W25Qx_PAGE_SIZE - 8
+ *        bytes of messages. Messages may continue on the next page.
+ *
+ * Pages are programmed once, in order: the page with sequence number seq
+ * sits at index seq % (pages in the region), which lets a mount find the
+ * newest page with a binary search.
+ */
+typedef struct {
+    uint16_t magic;        /*!< SYS_LOG_FLASH_MAGIC */
+    uint16_t used;         /*!< Message bytes in the page */
+    uint32_t seq;          /*!< Page sequence number */
+} sys_log_flash_hdr_t;
+
+/**
+ * @brief Header of a UDP log datagram, little-endian, followed by whole
+ *        messages (text lines or binary records) back to back.
+ */
+typedef struct {
+    uint16_t magic;        /*!< SYS_LOG_UDP_MAGIC */
+    uint8_t version;       /*!< SYS_LOG_UDP_VERSION */
+    uint8_t flags;         /*!< SYS_LOG_UDP_BINARY */
+    uint16_t node_id;      /*!< settings.node_id of the sender */
+    uint16_t count;        /*!< Messages in the datagram */
+    uint32_t seq;          /*!< Datagram number, +1 per datagram, restarts at 0 with the sink */
+} sys_log_udp_hdr_t;
+
+/**
+ * @brief Messages lost because the log arena was full.
+ */
+typedef struct {
+    uint32_t total;                         /*!< Messages dropped */
+    uint32_t sink[SYS_LOG_SINK_COUNT];      /*!< Drops per sink the message was meant for */
+    uint32_t level[SYS_LOG_VERBOSE + 1];    /*!< Drops per level */
+} sys_log_drops_t;
+
+/**
+ * @brief Binary log record, little-endian as stored on the target.
+ *
+ * Only the first SYS_LOG_BIN_SIZE(rec) bytes are sent or written. Records
+ * with preformatted text carry up to SYS_LOG_BIN_TEXT_WORDS words, more
+ * than args holds, and are built in a larger buffer by sys_log_write.
+ */
+typedef struct {
+    uint16_t magic;        /*!< SYS_LOG_BIN_MAGIC */
+    uint8_t level;         /*!< sys_log_level_t */
+    uint8_t nwords;        /*!< Number of valid words in args */
+#if SYS_LOG_TIMESTAMP_US
+    uint64_t timestamp;    /*!< sys_log_timestamp() at the call, at offset 8 */
+#else
+    uint32_t timestamp;    /*!< sys_log_timestamp() at the call */
+#endif
+    const char *tag;       /*!< Tag string address */
+    const char *format;    /*!< Format string address, without prefix and newline */
+    uint32_t args[SYS_LOG_BIN_MAX_WORDS]; /*!< Arguments as passed, 64-bit values low word first */
+} sys_log_bin_t;
+
+/** Size in bytes of the used part of a binary record */
+#define SYS_LOG_BIN_SIZE(rec) (offsetof(sys_log_bin_t, args) + (rec)->nwords * sizeof(uint32_t))
+
 /** Log tags */
 #define TAG_SYS  "SYS"
 
@@ -79,25 +351,76 @@ typedef struct {
         if ( LOG_LOCAL_LEVEL >= level ) SYS_LOG_LEVEL(level, tag, format, ##__VA_ARGS__); \
     } while(0)
 
-#define LOG_FORMAT(letter, format) letter " (%lu) %s: " format "\n"
-#define LOG_FILENAME_LEN (sizeof(LOG_MMC_DIR LOG_MMC_FILE_FORMAT))
+/** Log from an interrupt handler: the message is dropped (and counted) if the arena is full */
+#define SYS_LOG_FROM_ISR(level, tag, format, ...) do {                  \
+        if ( LOG_LOCAL_LEVEL >= level ) SYS_LOG_LEVEL_CTX(level, SYS_LOG_ISR, tag, format, ##__VA_ARGS__); \
+    } while(0)
+
+#define SYS_LOG_LEVEL(level, tag, format, ...) SYS_LOG_LEVEL_CTX(level, 0, tag, format, ##__VA_ARGS__)
 
-#define SYS_LOG_LEVEL(level, tag, format, ...) do {                     \
-        if (level==SYS_LOG_ERROR )          { sys_log_write(SYS_LOG_ERROR,      tag, LOG_FORMAT("E", format), sys_log_timestamp(), tag, ##__VA_ARGS__); } \
-        else if (level==SYS_LOG_WARN )      { sys_log_write(SYS_LOG_WARN,       tag, LOG_FORMAT("W", format), sys_log_timestamp(), tag, ##__VA_ARGS__); } \
-        else if (level==SYS_LOG_DEBUG )     { sys_log_write(SYS_LOG_DEBUG,      tag, LOG_FORMAT("D", format), sys_log_timestamp(), tag, ##__VA_ARGS__); } \
-        else if (level==SYS_LOG_VERBOSE )   { sys_log_write(SYS_LOG_VERBOSE,    tag, LOG_FORMAT("V", format), sys_log_timestamp(), tag, ##__VA_ARGS__); } \
-        else                                { sys_log_write(SYS_LOG_INFO,       tag, LOG_FORMAT("I", format), sys_log_timestamp(), tag, ##__VA_ARGS__); } \
+#define LOG_FORMAT(letter, format) letter " (" SYS_LOG_TIME_FMT ") %s: " format "\n"
+#define LOG_FILENAME_LEN (sizeof(LOG_MMC_DIR LOG_MMC_FILE_FORMAT) + 5)   // Up to 10 digits
+
+#if SYS_LOG_BINARY
+
+/** Argument classes of a binary log call, 2 bits each in the signature */
+#define SYS_LOG_ARG_WORD   0u
+#define SYS_LOG_ARG_INT64  1u
+#define SYS_LOG_ARG_DOUBLE 2u
+
+#define SYS_LOG_ARG_CLASS(x) _Generic((x), float: SYS_LOG_ARG_DOUBLE, double: SYS_LOG_ARG_DOUBLE, long double: SYS_LOG_ARG_DOUBLE, \
+        default: (sizeof((x) + 0) > 4u) ? SYS_LOG_ARG_INT64 : SYS_LOG_ARG_WORD)
+#define SYS_LOG_ARG_SIG(x, i) (SYS_LOG_ARG_CLASS(x) << (4 + 2 * (i)))
+
+#define SYS_LOG_NARGS(...) SYS_LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define SYS_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define SYS_LOG_CAT(a, b) SYS_LOG_CAT_(a, b)
+#define SYS_LOG_CAT_(a, b) a##b
+
+/** Call signature: argument count in bits 0..3, then the class of each argument */
+#define SYS_LOG_SIG(...) SYS_LOG_CAT(SYS_LOG_SIG_, SYS_LOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define SYS_LOG_SIG_0() 0u
+#define SYS_LOG_SIG_1(a) (1u | SYS_LOG_ARG_SIG(a, 0))
+#define SYS_LOG_SIG_2(a, b) (2u | SYS_LOG_ARG_SIG(a, 0) | SYS_LOG_ARG_SIG(b, 1))
+#define SYS_LOG_SIG_3(a, b, c) (3u | SYS_LOG_ARG_SIG(a, 0) | SYS_LOG_ARG_SIG(b, 1) | SYS_LOG_ARG_SIG(c, 2))
+#define SYS_LOG_SIG_4(a, b, c, d) (4u | SYS_LOG_ARG_SIG(a, 0) | SYS_LOG_ARG_SIG(b, 1) | SYS_LOG_ARG_SIG(c, 2) | SYS_LOG_ARG_SIG(d, 3))
+#define SYS_LOG_SIG_5(a, b, c, d, e) ((SYS_LOG_SIG_4(a, b, c, d) + 1u) | SYS_LOG_ARG_SIG(e, 4))
+#define SYS_LOG_SIG_6(a, b, c, d, e, f) ((SYS_LOG_SIG_5(a, b, c, d, e) + 1u) | SYS_LOG_ARG_SIG(f, 5))
+#define SYS_LOG_SIG_7(a, b, c, d, e, f, g) ((SYS_LOG_SIG_6(a, b, c, d, e, f) + 1u) | SYS_LOG_ARG_SIG(g, 6))
+#define SYS_LOG_SIG_8(a, b, c, d, e, f, g, h) ((SYS_LOG_SIG_7(a, b, c, d, e, f, g) + 1u) | SYS_LOG_ARG_SIG(h, 7))
+
+/** Never called, lets the compiler check the arguments against the format */
+static inline void __attribute__((format(printf, 1, 2))) sys_log_format_check(const char *format, ...) {
+    (void)format;
+}
+
+#define SYS_LOG_LEVEL_CTX(level, ctx, tag, format, ...) do {            \
+        if (0) sys_log_format_check(format, ##__VA_ARGS__);             \
+        if (sys_log_sinks(level, tag))                                  \
+            sys_log_write_bin((level) | (ctx), tag, format, SYS_LOG_SIG(__VA_ARGS__), ##__VA_ARGS__); \
     } while(0)
 
+#else
+
+#define SYS_LOG_LEVEL_CTX(level, ctx, tag, format, ...) do {            \
+        if (!sys_log_sinks(level, tag))     { }                         \
+        else if (level==SYS_LOG_ERROR )          { sys_log_write(SYS_LOG_ERROR | (ctx),      tag, LOG_FORMAT("E", format), sys_log_timestamp(), tag, ##__VA_ARGS__); } \
+        else if (level==SYS_LOG_WARN )      { sys_log_write(SYS_LOG_WARN | (ctx),       tag, LOG_FORMAT("W", format), sys_log_timestamp(), tag, ##__VA_ARGS__); } \
+        else if (level==SYS_LOG_DEBUG )     { sys_log_write(SYS_LOG_DEBUG | (ctx),      tag, LOG_FORMAT("D", format), sys_log_timestamp(), tag, ##__VA_ARGS__); } \
+        else if (level==SYS_LOG_VERBOSE )   { sys_log_write(SYS_LOG_VERBOSE | (ctx),    tag, LOG_FORMAT("V", format), sys_log_timestamp(), tag, ##__VA_ARGS__); } \
+        else                                { sys_log_write(SYS_LOG_INFO | (ctx),       tag, LOG_FORMAT("I", format), sys_log_timestamp(), tag, ##__VA_ARGS__); } \
+    } while(0)
+
+#endif /* SYS_LOG_BINARY */
+
 #define SCSS_FAIL(x) ((x) ? "success" : "fail")
 
 /**
  * @brief Get the current timestamp for logging.
  *
- * @return Current timestamp in milliseconds.
+ * @return Current timestamp in milliseconds, in microseconds with SYS_LOG_TIMESTAMP_US.
  */
-uint32_t sys_log_timestamp(void);
+sys_log_time_t sys_log_timestamp(void);
 
 /**
  * @brief Initialize the logging system.
@@ -113,14 +436,91 @@ void SYS_LOG_Init(sys_log_settings_t *settings);
  */
 void SYS_LOG_UpdateMethods(sys_log_settings_t *newSettings);
 
+/**
+ * @brief Read the drop counters.
+ *
+ * @param drops Receives a snapshot of the counters.
+ */
+void SYS_LOG_GetDrops(sys_log_drops_t *drops);
+
+/**
+ * @brief Read back a flash log region, oldest page first.
+ *
+ * Meant for post-mortem dumps, e.g. at boot; do not call it while the
+ * flash sink writes to the same chip.
+ *
+ * @param dev Flash chip.
+ * @param base Start of the log region.
+ * @param size Size of the log region.
+ * @param out Called with the messages of each page, in order.
+ * @param ctx Passed to out.
+ * @return uint32_t Number of pages read.
+ */
+uint32_t SYS_LOG_FlashRead(W25Qx_Device *dev, uint32_t base, uint32_t size,
+                           void (*out)(void *ctx, const uint8_t *data, uint16_t len), void *ctx);
+
+/**
+ * @brief Set the runtime level of a tag.
+ *
+ * Tags are matched by address, use the same string constant in the call
+ * and in the log macros.
+ *
+ * @param tag Tag string, NULL to set the level of every tag without its own.
+ * @param level Highest level let through.
+ * @return uint8_t 1 on success, 0 if the tag table is full.
+ */
+uint8_t SYS_LOG_SetLevel(const char *tag, sys_log_level_t level);
+
+/**
+ * @brief Set the highest level a sink takes, whatever the tag.
+ *
+ * Sink levels and the default tag level are reset by SYS_LOG_Init().
+ *
+ * @param sink Sink to configure.
+ * @param level Highest level written to the sink.
+ */
+void SYS_LOG_SetSinkLevel(sys_log_sink_t sink, sys_log_level_t level);
+
+/**
+ * @brief Sinks that take a message, checked by the log macros before formatting.
+ *
+ * @param level Message level, may carry SYS_LOG_ISR.
+ * @param tag Message tag.
+ * @return uint8_t Mask of running sinks (bit n is sys_log_sink_t n), 0 to skip the message.
+ */
+uint8_t sys_log_sinks(sys_log_level_t level, const char *tag);
+
 /**
  * @brief Write a log message.
  *
- * @param level Log level.
+ * @param level Log level, OR-ed with SYS_LOG_ISR when called from an interrupt.
  * @param tag Log tag.
  * @param format Message format string.
  * @param ... Additional arguments for the format string.
  */
 void sys_log_write(sys_log_level_t level, const char *tag, const char *format, ...);
 
+/**
+ * @brief Record a binary log message, used by SYS_LOG_LEVEL when SYS_LOG_BINARY is set.
+ *
+ * Copies the arguments into a sys_log_bin_t without formatting them.
+ *
+ * @param level Log level, OR-ed with SYS_LOG_ISR when called from an interrupt.
+ * @param tag Log tag.
+ * @param format Message format string.
+ * @param sig Argument signature built by SYS_LOG_SIG.
+ * @param ... Arguments for the format string.
+ */
+void sys_log_write_bin(sys_log_level_t level, const char *tag, const char *format, uint32_t sig, ...);
+
+/**
+ * @brief Format a binary record as a text line.
+ *
+ * @param rec Record to format.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return Length of the text, truncated to size - 1.
+ */
+size_t sys_log_render(const sys_log_bin_t *rec, char *buf, size_t size);
+
 #endif /* LOG_SYS_LOG_H_ */
@@ -0,0 +1,126 @@
+/**
+ * @file TimedBuffer.h
+ * @brief Circular buffer of timestamped items with age expiry and time lookups
+ *
+ * Every item carries a 32-bit tick or cycle count. Timestamps must be pushed
+ * in non-decreasing order, which keeps the ring sorted by time: lookups such
+ * as "first item at or after t" are binary searches (O(log n)) and items
+ * older than max_age are dropped from the front.
+ *
+ * Timestamps are compared wrap-safe, so a free-running counter (HAL tick,
+ * DWT->CYCCNT) may overflow as long as the buffered span stays below 2^31
+ * ticks. With max_age set the buffer also survives idle gaps of 2^31 ticks
+ * or more (about 25 s of DWT->CYCCNT at 84 MHz): a push or expiry more than
+ * max_age away from the newest item, in either direction, finds everything
+ * expired. Without max_age, call TB_Init again after such a gap. The buffer
+ * is meant for a single context; guard it externally when it is shared
+ * between an ISR and a task.
+ *
+ * @author [Nate Hunter]
+ * @date [16.10.2026]
+ * @version 1.0
+ */
+
+#ifndef TIMED_BUFFER_H
+#define TIMED_BUFFER_H
+
+#include <stdint.h>
+#include "CircularBuffer.h"
+
+/**
+ * @brief Timestamped ring, oldest item first.
+ */
+typedef struct {
+	void *data;            /**< size * item_size bytes of item storage. */
+	uint32_t *stamps;      /**< size timestamps, parallel to data. */
+	uint16_t size;         /**< Maximum number of items. */
+	uint16_t item_size;    /**< Size of a single item in bytes. */
+	uint16_t oldest;       /**< Slot of the oldest item. */
+	uint16_t count;        /**< Number of items stored. */
+	uint32_t max_age;      /**< Items older than this many ticks (< 2^31) expire, 0 keeps them until overwritten. */
+} TimedBuffer;
+
+/**
+ * @brief Initialize an empty buffer on caller-provided storage.
+ *
+ * @param tb Pointer to the buffer.
+ * @param data Item storage of size * item_size bytes.
+ * @param stamps Timestamp storage of size words.
+ * @param size Maximum number of items.
+ * @param item_size Size of a single item in bytes.
+ * @param max_age Expiry age in ticks below 2^31, 0 to disable.
+ */
+void TB_Init(TimedBuffer *tb, void *data, uint32_t *stamps, uint16_t size, uint16_t item_size, uint32_t max_age);
+
+/**
+ * @brief Append an item, overwriting the oldest one when the buffer is full.
+ *
+ * Items older than max_age relative to @p t are expired first, also after
+ * an idle gap of 2^31 ticks or more.
+ *
+ * @param tb Pointer to the buffer.
+ * @param t Timestamp of the item, not earlier than the newest one stored.
+ * @param item Pointer to the item.
+ * @return uint8_t 1 if stored, 0 if @p t is out of order.
+ */
+uint8_t TB_Push(TimedBuffer *tb, uint32_t t, const void *item);
+
+/**
+ * @brief Drop items older than max_age at time @p now.
+ *
+ * @param tb Pointer to the buffer.
+ * @param now Current timestamp.
+ * @return uint16_t Number of items dropped.
+ */
+uint16_t TB_Expire(TimedBuffer *tb, uint32_t now);
+
+/**
+ * @brief Get the i-th oldest item.
+ *
+ * @param tb Pointer to the buffer.
+ * @param i Index from the oldest item, less than tb->count.
+ * @param t Receives the timestamp, may be NULL.
+ * @return void* Pointer to the item, NULL if @p i is out of range.
+ */
+void *TB_At(const TimedBuffer *tb, uint16_t i, uint32_t *t);
+
+/**
+ * @brief Index of the first item with a timestamp at or after @p t.
+ *
+ * @param tb Pointer to the buffer.
+ * @param t Timestamp to look up.
+ * @return uint16_t Index from the oldest item, tb->count if every item is earlier.
+ */
+uint16_t TB_FindAtOrAfter(const TimedBuffer *tb, uint32_t t);
+
+/**
+ * @brief Index of the first item with a timestamp after @p t.
+ *
+ * @param tb Pointer to the buffer.
+ * @param t Timestamp to look up.
+ * @return uint16_t Index from the oldest item, tb->count if no item is later.
+ */
+uint16_t TB_FindAfter(const TimedBuffer *tb, uint32_t t);
+
+/**
+ * @brief Index of the item whose timestamp is closest to @p t.
+ *
+ * @param tb Pointer to the buffer.
+ * @param t Timestamp to look up.
+ * @return int32_t Index from the oldest item, -1 if the buffer is empty.
+ */
+int32_t TB_Nearest(const TimedBuffer *tb, uint32_t t);
+
+/**
+ * @brief Items with from <= timestamp < to, as up to two contiguous regions.
+ *
+ * @param tb Pointer to the buffer.
+ * @param from Start of the interval (inclusive).
+ * @param to End of the interval (exclusive).
+ * @param span Receives the regions, oldest first; span[1].count is 0 unless the range wraps.
+ * @param first Receives the index of the first item in the range, may be NULL.
+ * @return uint16_t Number of items in the range.
+ */
+uint16_t TB_Range(const TimedBuffer *tb, uint32_t from, uint32_t to, CB_Span span[2], uint16_t *first);
+
+#endif // TIMED_BUFFER_H
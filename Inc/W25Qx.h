@@ -25,9 +25,12 @@
 
 // Command definitions
 #define W25Qx_CMD_READ          0x03
+#define W25Qx_CMD_FAST_READ     0x0B
 #define W25Qx_CMD_WRITE_ENABLE  0x06
 #define W25Qx_CMD_PAGE_PROGRAM  0x02
 #define W25Qx_CMD_SECTOR_ERASE  0x20
+#define W25Qx_CMD_BLOCK32_ERASE 0x52
+#define W25Qx_CMD_BLOCK64_ERASE 0xD8
 #define W25Qx_CMD_READ_SR1      0x05
 #define W25Qx_CMD_JEDEC_ID      0x9F
 #define W25Qx_CMD_CHIP_ERASE		0xC7
@@ -38,19 +41,105 @@
 // Device parameters
 #define W25Qx_PAGE_SIZE         256
 #define W25Qx_SECTOR_SIZE       4096
+#define W25Qx_BLOCK32_SIZE      32768
+#define W25Qx_BLOCK64_SIZE      65536
 #define W25Qx_TIMEOUT           1000
 
+// Erase time limits in ms: datasheet maxima with margin
+#define W25Qx_TIMEOUT_SECTOR_ERASE  W25Qx_TIMEOUT
+#define W25Qx_TIMEOUT_BLOCK32_ERASE 2000
+#define W25Qx_TIMEOUT_BLOCK64_ERASE 3000
+#define W25Qx_TIMEOUT_CHIP_ERASE_MB 18750 ///< Per MB of capacity; the datasheets give 12.5 s.
+
 /**
- * @brief Structure representing a W25Qx device.
+ * @brief Command of data reads.
+ *
+ * Fast Read takes one dummy byte after the address and runs at the full
+ * rated clock of every supported part; plain Read (0x03) is limited to a
+ * lower clock on most of them.
+ */
+#ifndef W25Qx_READ_CMD
+#define W25Qx_READ_CMD          W25Qx_CMD_FAST_READ
+#endif
+#define W25Qx_READ_DUMMY        ((W25Qx_READ_CMD) == W25Qx_CMD_FAST_READ ? 1 : 0)
+
+// Asynchronous engine parameters
+#ifndef W25Qx_QUEUE_LEN
+#define W25Qx_QUEUE_LEN         8    ///< Jobs queued per device.
+#endif
+#ifndef W25Qx_POLL_LEN
+#define W25Qx_POLL_LEN          2    ///< Bytes per status poll transfer, the command included.
+#endif
+#ifndef W25Qx_POLL_PROGRAM_MS
+#define W25Qx_POLL_PROGRAM_MS   1    ///< Status poll period while a page programs.
+#endif
+#ifndef W25Qx_POLL_ERASE_DIV
+#define W25Qx_POLL_ERASE_DIV    128  ///< Status polls per erase time limit.
+#endif
+#define W25Qx_XFER_MAX          0xFFFF ///< Largest single HAL SPI transfer.
+
+typedef struct W25Qx_Device W25Qx_Device;
+
+/**
+ * @brief Completion callback of an asynchronous job.
+ *
+ * Runs in interrupt context, from W25Qx_SPI_IRQHandler() or
+ * W25Qx_AsyncProcess(). To wake a task, give it a notification here
+ * (vTaskNotifyGiveFromISR()).
+ *
+ * @param dev Device the job ran on.
+ * @param ok 1 if the job succeeded, 0 on an SPI error or timeout.
+ * @param ctx Context passed at submission.
+ */
+typedef void (*W25Qx_Callback)(W25Qx_Device *dev, uint8_t ok, void *ctx);
+
+/**
+ * @brief Asynchronous job kinds.
+ */
+typedef enum {
+    W25Qx_JOB_READ,
+    W25Qx_JOB_PROGRAM,
+    W25Qx_JOB_ERASE
+} W25Qx_JobType;
+
+/**
+ * @brief Queued asynchronous job.
  */
 typedef struct {
+    uint8_t type;            ///< W25Qx_JobType.
+    uint32_t address;        ///< Start address.
+    uint8_t *data;           ///< Data buffer, unused by erases.
+    uint32_t length;         ///< Bytes to read, program or erase.
+    W25Qx_Callback callback; ///< Completion callback, may be NULL.
+    void *ctx;               ///< Callback context.
+} W25Qx_Job;
+
+/**
+ * @brief Structure representing a W25Qx device.
+ */
+struct W25Qx_Device {
     SPI_HandleTypeDef *spi;  ///< SPI handle for communication.
     GPIO_TypeDef *cs_port;   ///< GPIO port for chip select (CS).
     uint16_t cs_pin;         ///< GPIO pin for chip select (CS).
     uint32_t capacity;       ///< Device capacity in bytes.
     uint8_t *txbuf;          ///< Pointer to the TX buffer.
     uint8_t *rxbuf;          ///< Pointer to the RX buffer.
-} W25Qx_Device;
+
+    // Asynchronous engine state, owned by the driver
+    W25Qx_Job jobs[W25Qx_QUEUE_LEN];  ///< Job ring, jobs[job_head] is running.
+    volatile uint8_t job_head;        ///< Index of the running job.
+    volatile uint8_t job_count;       ///< Jobs queued, including the running one.
+    volatile uint8_t phase;           ///< Step of the running job.
+    uint32_t done;                    ///< Bytes of the running job completed.
+    uint32_t chunk;                   ///< Bytes of the transfer in flight.
+    uint32_t poll_start;              ///< Tick the current busy wait started.
+    uint32_t poll_timeout;            ///< Limit of the current busy wait in ms.
+    uint32_t poll_last;               ///< Tick of the last status poll.
+    uint32_t poll_period;             ///< Time between status polls in ms.
+    uint8_t cmd[5];                   ///< Command, address and dummy bytes.
+    uint8_t poll_tx[W25Qx_POLL_LEN];  ///< Read Status Register 1 command.
+    uint8_t poll_rx[W25Qx_POLL_LEN];  ///< Status bytes of the last poll.
+};
 
 /**
  * @brief Initialize the W25Qx device.
@@ -63,6 +152,9 @@ uint8_t W25Qx_Init(W25Qx_Device *dev);
 /**
  * @brief Wait for the W25Qx device to be ready.
  *
+ * Fails while asynchronous jobs are queued: the blocking functions must
+ * not interleave with them.
+ *
  * @param dev Pointer to the W25Qx device structure.
  * @param timeout Timeout in milliseconds.
  * @return 1 if the device is ready, 0 otherwise.
@@ -103,13 +195,19 @@ uint8_t W25Qx_WriteData(W25Qx_Device *dev, uint32_t address, const void *buffer,
 /**
  * @brief Erase the entire chip.
  *
+ * Waits up to W25Qx_TIMEOUT_CHIP_ERASE_MB per MB of capacity.
+ *
  * @param dev Pointer to the W25Qx device structure.
  * @return 1 if the operation succeeds, 0 otherwise.
  */
 uint8_t W25Qx_EraseChip(W25Qx_Device *dev);
 
 /**
- * @brief Erase multiple sectors sequentially.
+ * @brief Erase the sectors covering a range with as few commands as possible.
+ *
+ * Aligned 64KB and 32KB blocks inside the range go with one block erase
+ * each, the rest with 4KB sector erases; a range covering the whole
+ * device becomes a chip erase.
  *
  * @param dev Pointer to the W25Qx device structure.
  * @param start_address Starting address of the first sector to erase.
@@ -118,4 +216,101 @@ uint8_t W25Qx_EraseChip(W25Qx_Device *dev);
  */
 uint8_t W25Qx_EraseSectors(W25Qx_Device *dev, uint32_t start_address, uint32_t length);
 
+/**
+ * @brief Queue an asynchronous read.
+ *
+ * Data moves by SPI DMA; a read longer than W25Qx_XFER_MAX is split into
+ * several commands.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param address Address to read from.
+ * @param buffer Receives the data, must stay valid until the callback.
+ * @param length Number of bytes to read.
+ * @param callback Called when the read is done, may be NULL.
+ * @param ctx Passed to the callback.
+ * @return 1 if the job is queued, 0 if the queue is full.
+ */
+uint8_t W25Qx_ReadAsync(W25Qx_Device *dev, uint32_t address, void *buffer, uint32_t length,
+                        W25Qx_Callback callback, void *ctx);
+
+/**
+ * @brief Queue an asynchronous program of erased flash.
+ *
+ * The data is split at page boundaries. Each page is sent by DMA, then
+ * the busy flag is polled from W25Qx_AsyncProcess() before the next page
+ * starts.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param address Address to write to.
+ * @param buffer Data to write, must stay valid until the callback.
+ * @param length Number of bytes to write.
+ * @param callback Called when the last page is programmed, may be NULL.
+ * @param ctx Passed to the callback.
+ * @return 1 if the job is queued, 0 if the queue is full.
+ */
+uint8_t W25Qx_ProgramAsync(W25Qx_Device *dev, uint32_t address, const void *buffer, uint32_t length,
+                           W25Qx_Callback callback, void *ctx);
+
+/**
+ * @brief Queue an asynchronous erase of the 4KB sectors covering a range.
+ *
+ * Planned like W25Qx_EraseSectors(): block and chip erases where they fit.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param address Starting address, aligned down to a sector.
+ * @param length Number of bytes to erase.
+ * @param callback Called when the last sector is erased, may be NULL.
+ * @param ctx Passed to the callback.
+ * @return 1 if the job is queued, 0 if the queue is full.
+ */
+uint8_t W25Qx_EraseAsync(W25Qx_Device *dev, uint32_t address, uint32_t length,
+                         W25Qx_Callback callback, void *ctx);
+
+/**
+ * @brief Check whether all asynchronous jobs of a device are done.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @return 1 if the job queue is empty, 0 otherwise.
+ */
+uint8_t W25Qx_AsyncIdle(W25Qx_Device *dev);
+
+/**
+ * @brief Poll the busy flag of a running program or erase when it is due.
+ *
+ * Call every millisecond, e.g. from vApplicationTickHook() or the HAL
+ * time base timer callback. While the chip is busy no SPI transfer is in
+ * flight: each poll is one short DMA transfer, every W25Qx_POLL_PROGRAM_MS
+ * during a page program and every 1/W25Qx_POLL_ERASE_DIV of the time
+ * limit during an erase.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ */
+void W25Qx_AsyncProcess(W25Qx_Device *dev);
+
+/**
+ * @brief SPI transfer complete handler — call from HAL_SPI_TxCpltCallback,
+ *        HAL_SPI_RxCpltCallback and HAL_SPI_TxRxCpltCallback.
+ *
+ * Transfers on other SPI handles are ignored.
+ *
+ * Command headers (up to 5 bytes) are sent polled from this handler, with
+ * a HAL timeout counted on HAL_GetTick(): give the HAL time base interrupt
+ * a higher priority (lower number) than the SPI DMA interrupts, or a stuck
+ * SPI hangs the handler.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param hspi SPI handle passed to the HAL callback.
+ */
+void W25Qx_SPI_IRQHandler(W25Qx_Device *dev, SPI_HandleTypeDef *hspi);
+
+/**
+ * @brief SPI error handler — call from HAL_SPI_ErrorCallback.
+ *
+ * Fails the running job and moves on to the next one.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param hspi SPI handle passed to the HAL callback.
+ */
+void W25Qx_SPI_ErrorHandler(W25Qx_Device *dev, SPI_HandleTypeDef *hspi);
+
 #endif // W25QX_H
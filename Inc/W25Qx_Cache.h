@@ -0,0 +1,103 @@
+/**
+ * @file W25Qx_Cache.h
+ * @brief Write-back sector cache for W25Qx SPI Flash memory.
+ *
+ * Holds whole 4KB sectors in RAM so that many small writes to a sector
+ * cost one erase/program cycle when the line is flushed, on eviction or
+ * W25Qx_CacheSync(). A flush skips the erase when the writes only cleared
+ * bits (1 -> 0) and programs only the pages that changed.
+ *
+ * Writes allocate a line (reading the sector first), reads are served from
+ * cached lines and go straight to the flash otherwise. Lines are evicted
+ * least recently used first. Not reentrant: use from one task.
+ *
+ * A reset during a flush that erases loses the sector contents; keep data
+ * that must survive power loss in a log-structured layout instead.
+ *
+ * @author [Nate Hunter]
+ * @date [16.10.2026]
+ * @version 1.0
+ */
+
+#ifndef W25QX_CACHE_H
+#define W25QX_CACHE_H
+
+#include "W25Qx.h"
+
+#define W25Qx_CACHE_NONE        0xFFFFFFFF
+#define W25Qx_CACHE_PAGES       (W25Qx_SECTOR_SIZE / W25Qx_PAGE_SIZE)
+
+/**
+ * @brief One cached sector.
+ */
+typedef struct {
+    uint32_t address;        ///< Sector address, W25Qx_CACHE_NONE if unused.
+    uint32_t stamp;          ///< Last use, for LRU eviction.
+    uint16_t dirty;          ///< Bit n set: page n differs from the flash.
+    uint8_t erase;           ///< A write set a bit, the flush must erase.
+    uint8_t data[W25Qx_SECTOR_SIZE]; ///< Sector contents.
+} W25Qx_CacheLine;
+
+/**
+ * @brief Cache over one device.
+ */
+typedef struct {
+    W25Qx_Device *dev;       ///< Cached device.
+    W25Qx_CacheLine *lines;  ///< Lines provided by the caller.
+    uint8_t count;           ///< Number of lines.
+    uint32_t clock;          ///< Use counter for the LRU stamps.
+} W25Qx_Cache;
+
+/**
+ * @brief Initialize a cache.
+ *
+ * @param cache Pointer to the cache structure.
+ * @param dev Initialized device to cache.
+ * @param lines Storage for the lines, e.g. a static array.
+ * @param count Number of lines, at least 1.
+ * @return uint8_t 1 if successful, 0 if there are no lines.
+ */
+uint8_t W25Qx_CacheInit(W25Qx_Cache *cache, W25Qx_Device *dev, W25Qx_CacheLine *lines, uint8_t count);
+
+/**
+ * @brief Read data, including writes not flushed yet.
+ *
+ * @param cache Pointer to the cache structure.
+ * @param address Address to read from.
+ * @param buffer Pointer to the buffer to store read data.
+ * @param length Number of bytes to read.
+ * @return 1 if the operation succeeds, 0 otherwise.
+ */
+uint8_t W25Qx_CacheRead(W25Qx_Cache *cache, uint32_t address, void *buffer, uint32_t length);
+
+/**
+ * @brief Write data; the flash does not need to be erased.
+ *
+ * @param cache Pointer to the cache structure.
+ * @param address Address to write to.
+ * @param buffer Pointer to the data to write.
+ * @param length Number of bytes to write.
+ * @return 1 if the operation succeeds, 0 if a line could not be loaded or evicted.
+ */
+uint8_t W25Qx_CacheWrite(W25Qx_Cache *cache, uint32_t address, const void *buffer, uint32_t length);
+
+/**
+ * @brief Flush every dirty line to the flash.
+ *
+ * Lines stay cached.
+ *
+ * @param cache Pointer to the cache structure.
+ * @return 1 if the operation succeeds, 0 otherwise.
+ */
+uint8_t W25Qx_CacheSync(W25Qx_Cache *cache);
+
+/**
+ * @brief Drop every line without flushing it.
+ *
+ * Call after writing the device around the cache.
+ *
+ * @param cache Pointer to the cache structure.
+ */
+void W25Qx_CacheInvalidate(W25Qx_Cache *cache);
+
+#endif // W25QX_CACHE_H
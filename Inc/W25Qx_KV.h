@@ -0,0 +1,157 @@
+/**
+ * @file W25Qx_KV.h
+ * @brief Log-structured key-value store on W25Qx SPI Flash memory.
+ *
+ * Every update appends a CRC-checked record to the active sector of a
+ * partition; the newest record of a key wins. A RAM hash index maps each
+ * key to its newest record, built by scanning the partition at mount, so
+ * a lookup costs one flash read of the record.
+ *
+ * When the free sectors run out, garbage collection copies the live
+ * records of a victim sector to the active one and erases the victim.
+ * The victim is the sector with the most superseded data, unless a sector
+ * has been erased W25Qx_KV_WEAR_DELTA times less than the most worn one:
+ * then its (cold) data is moved so the sector joins the rotation. New
+ * sectors are taken least worn first. Erase counts are kept in the sector
+ * headers.
+ *
+ * A reset at any point leaves either the old or the new value of a key:
+ * torn records fail their CRC and are skipped at mount. A collection cut
+ * off while copying into a sector it took is rolled back at mount, so the
+ * free sector it used is never lost. Not reentrant: use from one task.
+ *
+ * @author [Nate Hunter]
+ * @date [16.10.2026]
+ * @version 1.0
+ */
+
+#ifndef W25QX_KV_H
+#define W25QX_KV_H
+
+#include "W25Qx.h"
+
+#ifndef W25Qx_KV_MAX_SECTORS
+#define W25Qx_KV_MAX_SECTORS    32   ///< Largest partition, in 4KB sectors.
+#endif
+#ifndef W25Qx_KV_INDEX_SIZE
+#define W25Qx_KV_INDEX_SIZE     64   ///< Index slots, a power of two; 3/4 of them hold keys.
+#endif
+#ifndef W25Qx_KV_WEAR_DELTA
+#define W25Qx_KV_WEAR_DELTA     100  ///< Erase count gap that triggers moving cold data.
+#endif
+#define W25Qx_KV_KEY_MAX        32   ///< Longest key, in bytes.
+#define W25Qx_KV_VALUE_MAX      1024 ///< Longest value, in bytes.
+
+#define W25Qx_KV_MAGIC          0x3153564B // "KVS1"
+#define W25Qx_KV_FREE           0xFFFFFFFF // Sequence number of an erased sector
+#define W25Qx_KV_DELETED        0x01       // Record flag: the key was deleted
+
+/**
+ * @brief Header at the start of every sector of the partition.
+ *
+ * The erase count is written right after the erase, the sequence number
+ * and source later, when the sector is taken into use: programming only
+ * clears bits.
+ */
+typedef struct {
+    uint32_t magic;          ///< W25Qx_KV_MAGIC.
+    uint32_t erases;         ///< Times the sector was erased.
+    uint32_t erases_check;   ///< ~erases.
+    uint32_t seq;            ///< Order the sector was taken in, W25Qx_KV_FREE if free.
+    uint32_t seq_check;      ///< ~seq, W25Qx_KV_FREE if free.
+    uint32_t source;         ///< Sector collected into this one when it was taken, W25Qx_KV_FREE if none.
+    uint32_t source_check;   ///< ~source, W25Qx_KV_FREE if free.
+} W25Qx_KVHeader;
+
+/**
+ * @brief Header of a record, followed by the key, the value and padding to 4 bytes.
+ */
+typedef struct {
+    uint8_t key_len;         ///< Key length, 0xFF where nothing was written.
+    uint8_t flags;           ///< W25Qx_KV_DELETED for a deletion.
+    uint16_t value_len;      ///< Value length.
+    uint32_t crc;            ///< CRC-32 of the fields above, the key and the value.
+} W25Qx_KVRecord;
+
+/**
+ * @brief Index slot: newest record of a key.
+ */
+typedef struct {
+    uint32_t hash;           ///< Key hash.
+    uint32_t offset;         ///< Record offset in the partition, 0 if the slot is empty.
+    uint16_t size;           ///< Record size including padding.
+    uint8_t deleted;         ///< The record is a deletion.
+} W25Qx_KVEntry;
+
+/**
+ * @brief State of one sector.
+ */
+typedef struct {
+    uint32_t seq;            ///< Order the sector was taken in, W25Qx_KV_FREE if free.
+    uint32_t erases;         ///< Times the sector was erased.
+    uint16_t used;           ///< Bytes written, header included.
+    uint16_t live;           ///< Bytes of records still in the index.
+    uint8_t source;          ///< Sector collected into this one when it was taken, 0xFF if none.
+} W25Qx_KVSector;
+
+/**
+ * @brief Key-value store over one partition.
+ */
+typedef struct {
+    W25Qx_Device *dev;       ///< Flash chip.
+    uint32_t base;           ///< Partition start, sector aligned.
+    uint8_t sectors;         ///< Sectors in the partition.
+    uint8_t free;            ///< Erased sectors.
+    uint8_t active;          ///< Sector records are appended to, 0xFF if none.
+    uint32_t seq;            ///< Newest sector sequence number.
+    uint16_t count;          ///< Keys in the index, deletions included.
+    W25Qx_KVSector sector[W25Qx_KV_MAX_SECTORS]; ///< Sector states.
+    W25Qx_KVEntry index[W25Qx_KV_INDEX_SIZE];    ///< Key index.
+} W25Qx_KV;
+
+/**
+ * @brief Mount a partition, formatting sectors that hold no valid header.
+ *
+ * @param kv Pointer to the store structure.
+ * @param dev Initialized flash chip.
+ * @param base Partition start, sector aligned.
+ * @param size Partition size, 3 to W25Qx_KV_MAX_SECTORS sectors.
+ * @return 1 if the operation succeeds, 0 otherwise.
+ */
+uint8_t W25Qx_KVMount(W25Qx_KV *kv, W25Qx_Device *dev, uint32_t base, uint32_t size);
+
+/**
+ * @brief Read the value of a key.
+ *
+ * @param kv Pointer to the store structure.
+ * @param key Null-terminated key.
+ * @param value Receives up to size bytes of the value.
+ * @param size Size of the value buffer.
+ * @param length Receives the full value length, may be NULL.
+ * @return 1 if the key exists, 0 otherwise.
+ */
+uint8_t W25Qx_KVGet(W25Qx_KV *kv, const char *key, void *value, uint16_t size, uint16_t *length);
+
+/**
+ * @brief Store the value of a key.
+ *
+ * Writing the value a key already has costs no flash write.
+ *
+ * @param kv Pointer to the store structure.
+ * @param key Null-terminated key, 1 to W25Qx_KV_KEY_MAX bytes.
+ * @param value Value bytes.
+ * @param length Value length, up to W25Qx_KV_VALUE_MAX.
+ * @return 1 if the operation succeeds, 0 if the store is full or on a flash error.
+ */
+uint8_t W25Qx_KVSet(W25Qx_KV *kv, const char *key, const void *value, uint16_t length);
+
+/**
+ * @brief Delete a key.
+ *
+ * @param kv Pointer to the store structure.
+ * @param key Null-terminated key.
+ * @return 1 if the key was deleted, 0 if it did not exist or on a flash error.
+ */
+uint8_t W25Qx_KVDelete(W25Qx_KV *kv, const char *key);
+
+#endif // W25QX_KV_H
@@ -6,58 +6,424 @@
 #include "CircularBuffer.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+
+/** Order slot accesses against index loads/stores (DMB on Cortex-M). */
+#define CB_ACQUIRE() atomic_thread_fence(memory_order_acquire)
+#define CB_RELEASE() atomic_thread_fence(memory_order_release)
+
+/** Running indices wrap at a multiple of size so that index % size stays continuous. */
+#define CB_WRAP(b) ((uint32_t)(b)->size << 24)
+
+static inline uint32_t cb_advance(const CircularBuffer *b, uint32_t i, uint32_t n) {
+    i += n;
+    return (i >= CB_WRAP(b)) ? i - CB_WRAP(b) : i;
+}
+
+static inline uint32_t cb_distance(const CircularBuffer *b, uint32_t from, uint32_t to) {
+    return (to >= from) ? to - from : to + (CB_WRAP(b) - from);
+}
+
+static inline char *cb_slot(const CircularBuffer *b, uint32_t i) {
+    return (char*)b->data + (i % b->size) * b->item_size;
+}
+
+/**
+ * @brief Get the oldest intact element and the element count.
+ *
+ * When the producer has overwritten unread elements, the window is clamped
+ * to the last size - 1 pushes.
+ */
+static uint32_t cb_oldest(const CircularBuffer *b, uint32_t *count) {
+    uint32_t head = b->head;
+    uint32_t used = cb_distance(b, head, b->tail);
+    if (used > b->size - 1u) {
+        head = cb_advance(b, head, used - (b->size - 1u));
+        used = b->size - 1u;
+    }
+    *count = used;
+    return head;
+}
+
+/**
+ * @brief Split count elements starting at running index i into two contiguous regions.
+ */
+static void cb_split(const CircularBuffer *b, uint32_t i, uint32_t count, CB_Span span[2]) {
+    uint32_t slot = i % b->size;
+    uint32_t first = b->size - slot;
+    if (first > count) first = count;
+
+    span[0].ptr = (char*)b->data + slot * b->item_size;
+    span[0].count = first;
+    span[1].ptr = b->data;
+    span[1].count = count - first;
+}
+
+/**
+ * @brief Consumer-side head, skipping elements lost to an overrun.
+ */
+static uint32_t cb_consumer_head(CircularBuffer *b, uint32_t *count) {
+    uint32_t head = b->head;
+    uint32_t oldest = cb_oldest(b, count);
+    if (oldest != head) {
+        b->drops += cb_distance(b, head, oldest);
+        b->head = oldest;
+    }
+    return oldest;
+}
 
+/**
+ * @brief Attach memory and reset indices and counters.
+ */
+static void cb_reset(CircularBuffer *b, void *data, CB_Storage storage, CB_Pool *pool) {
+    b->data = data;
+    b->storage = storage;
+    b->pool = pool;
+    b->head = 0;
+    b->tail = 0;
+    b->drops = 0;
+    b->high_water = 0;
+}
+
+#ifndef CB_NO_HEAP
 /**
  * @brief Create a circular buffer.
  *
  * @param buffer Pointer to buffer structure.
  */
 void CB_Init(CircularBuffer *buffer) {
-    buffer->data = malloc(buffer->size * buffer->item_size);
-    buffer->head = 0;
-    buffer->tail = 0;
+    cb_reset(buffer, malloc(buffer->size * buffer->item_size), CB_STORAGE_HEAP, NULL);
+}
+#endif
+
+/**
+ * @brief Create a circular buffer on caller-provided memory.
+ *
+ * @param buffer Pointer to buffer structure.
+ * @param storage Memory of at least size * item_size bytes.
+ */
+void CB_InitStatic(CircularBuffer *buffer, void *storage) {
+    cb_reset(buffer, storage, CB_STORAGE_STATIC, NULL);
+}
+
+/**
+ * @brief Create a circular buffer on a block taken from a pool.
+ *
+ * @param buffer Pointer to buffer structure.
+ * @param pool Pool to take the block from.
+ * @return uint8_t 1 on success, 0 if the pool is empty or its blocks are too small.
+ */
+uint8_t CB_InitPool(CircularBuffer *buffer, CB_Pool *pool) {
+    void *block = pool->free_list;
+    if (block == NULL || (uint32_t)buffer->size * buffer->item_size > pool->block_size) {
+        return 0;
+    }
+    pool->free_list = *(void**)block;
+    pool->free_count--;
+    cb_reset(buffer, block, CB_STORAGE_POOL, pool);
+    return 1;
 }
 
 /**
- * @brief Free the memory allocated for the circular buffer.
+ * @brief Release the buffer memory according to its origin.
  *
  * @param buffer Pointer to the buffer.
  */
 void CB_Free(CircularBuffer *buffer) {
-    free(buffer->data);
-    free(buffer);
+    switch (buffer->storage) {
+#ifndef CB_NO_HEAP
+        case CB_STORAGE_HEAP:
+            free(buffer->data);
+            break;
+#endif
+        case CB_STORAGE_POOL:
+            *(void**)buffer->data = buffer->pool->free_list;
+            buffer->pool->free_list = buffer->data;
+            buffer->pool->free_count++;
+            break;
+        default:
+            break;
+    }
+    buffer->data = NULL;
+}
+
+/**
+ * @brief Build a pool over caller-provided memory.
+ *
+ * @param pool Pointer to the pool.
+ * @param storage Memory of block_size * count bytes, pointer-aligned.
+ * @param block_size Size of one block in bytes, a multiple of the pointer size.
+ * @param count Number of blocks.
+ */
+void CB_PoolInit(CB_Pool *pool, void *storage, uint16_t block_size, uint16_t count) {
+    char *block = storage;
+    pool->free_list = NULL;
+    pool->block_size = block_size;
+    pool->free_count = count;
+
+    // Chain blocks so the lowest address is handed out first
+    for (uint16_t i = count; i > 0; i--) {
+        *(void**)(block + (uint32_t)(i - 1) * block_size) = pool->free_list;
+        pool->free_list = block + (uint32_t)(i - 1) * block_size;
+    }
 }
 
 /**
- * @brief Push an item to the circular buffer.
+ * @brief Push an item to the circular buffer (producer side).
+ *
+ * Only @c tail is written. In CB_OVERWRITE mode a full buffer is not checked
+ * here: the consumer notices the overrun and skips the lost elements.
  *
  * @param buffer Pointer to the buffer.
  * @param item Pointer to the item to add.
+ * @return uint8_t 1 if stored, 0 if rejected because the buffer is full.
  */
-void CB_Push(CircularBuffer *buffer, const void *item) {
-    memcpy((char*)buffer->data + (buffer->tail * buffer->item_size), item, buffer->item_size);
-    buffer->tail = (buffer->tail + 1) % buffer->size;
-    if(buffer->tail == buffer->head) {
-        buffer->head = (buffer->head + 1) % buffer->size;
+uint8_t CB_Push(CircularBuffer *buffer, const void *item) {
+    uint32_t tail = buffer->tail;
+    uint32_t used = cb_distance(buffer, buffer->head, tail);
+    CB_ACQUIRE(); // Consumer must be done with the slot before it is reused
+
+    if (used >= buffer->size - 1u) {
+        if (buffer->policy == CB_REJECT) {
+            buffer->drops++;
+            return 0;
+        }
+        used = buffer->size - 2u;
     }
+
+    memcpy(cb_slot(buffer, tail), item, buffer->item_size);
+    CB_RELEASE(); // Publish data before the index
+    buffer->tail = cb_advance(buffer, tail, 1);
+
+    if (used + 1u > buffer->high_water) {
+        buffer->high_water = used + 1u;
+    }
+    return 1;
 }
 
 /**
- * @brief Pop an item from the circular buffer.
+ * @brief Pop an item from the circular buffer (consumer side).
+ *
+ * Only @c head is written. In CB_OVERWRITE mode the copy is validated against
+ * the producer index afterwards and retried if the slot was reused meanwhile.
  *
  * @param buffer Pointer to the buffer.
  * @param item Pointer to store the popped item.
  * @return int 1 if successful, 0 if buffer is empty.
  */
 uint8_t CB_Pop(CircularBuffer *buffer, void *item) {
-    if (buffer->head == buffer->tail) {
-        return 0; // Buffer is empty
+    uint32_t head = buffer->head;
+
+    for (;;) {
+        uint32_t used = cb_distance(buffer, head, buffer->tail);
+        CB_ACQUIRE(); // Read data only after the index that published it
+
+        if (used == 0) {
+            buffer->head = head;
+            return 0; // Buffer is empty
+        }
+        if (used > buffer->size - 1u) {
+            // Producer lapped us, skip to the oldest element still intact
+            buffer->drops += used - (buffer->size - 1u);
+            head = cb_advance(buffer, head, used - (buffer->size - 1u));
+        }
+
+        memcpy(item, cb_slot(buffer, head), buffer->item_size);
+        if (buffer->policy == CB_REJECT) {
+            break;
+        }
+
+        CB_ACQUIRE(); // Finish the copy before re-checking the producer
+        if (cb_distance(buffer, head, buffer->tail) < buffer->size) {
+            break; // Slot was not reused while copying
+        }
     }
-    memcpy(item, (char*)buffer->data + (buffer->head * buffer->item_size), buffer->item_size);
-    buffer->head = (buffer->head + 1) % buffer->size;
+
+    CB_RELEASE(); // Release the slot only after the copy
+    buffer->head = cb_advance(buffer, head, 1);
     return 1;
 }
 
+/**
+ * @brief Push up to n items with at most two block copies (producer side).
+ *
+ * @param buffer Pointer to the buffer.
+ * @param items Pointer to the first item.
+ * @param n Number of items.
+ * @return uint32_t Number of items stored.
+ */
+uint32_t CB_PushN(CircularBuffer *buffer, const void *items, uint32_t n) {
+    const uint32_t capacity = buffer->size - 1u;
+    uint32_t tail = buffer->tail;
+    uint32_t used = cb_distance(buffer, buffer->head, tail);
+    uint32_t skip = 0;
+    CB_ACQUIRE();
+
+    if (used > capacity) used = capacity;
+    if (buffer->policy == CB_REJECT) {
+        if (n > capacity - used) {
+            buffer->drops += n - (capacity - used);
+            n = capacity - used;
+        }
+    } else if (n > capacity) {
+        // Only the last items survive, the rest would be overwritten anyway
+        skip = n - capacity;
+    }
+
+    CB_Span span[2];
+    uint32_t start = cb_advance(buffer, tail, skip);
+    const char *src = (const char*)items + skip * buffer->item_size;
+    cb_split(buffer, start, n - skip, span);
+    memcpy(span[0].ptr, src, span[0].count * buffer->item_size);
+    memcpy(span[1].ptr, src + span[0].count * buffer->item_size, span[1].count * buffer->item_size);
+
+    CB_RELEASE();
+    buffer->tail = cb_advance(buffer, tail, n);
+
+    used = (used + n > capacity) ? capacity : used + n;
+    if (used > buffer->high_water) {
+        buffer->high_water = used;
+    }
+    return n;
+}
+
+/**
+ * @brief Pop up to n items with at most two block copies (consumer side).
+ *
+ * @param buffer Pointer to the buffer.
+ * @param items Pointer to store the popped items.
+ * @param n Maximum number of items.
+ * @return uint32_t Number of items popped.
+ */
+uint32_t CB_PopN(CircularBuffer *buffer, void *items, uint32_t n) {
+    uint32_t used;
+    uint32_t head = cb_consumer_head(buffer, &used);
+    CB_ACQUIRE();
+    if (n > used) n = used;
+    if (n == 0) return 0;
+
+    CB_Span span[2];
+    cb_split(buffer, head, n, span);
+    memcpy(items, span[0].ptr, span[0].count * buffer->item_size);
+    memcpy((char*)items + span[0].count * buffer->item_size, span[1].ptr, span[1].count * buffer->item_size);
+
+    if (buffer->policy != CB_REJECT) {
+        CB_ACQUIRE();
+        uint32_t used_now = cb_distance(buffer, head, buffer->tail);
+        if (used_now >= buffer->size) {
+            // Oldest copied items were reused while copying, keep the intact rest
+            uint32_t lost = used_now - (buffer->size - 1u);
+            if (lost > n) lost = n;
+            memmove(items, (char*)items + lost * buffer->item_size, (n - lost) * buffer->item_size);
+            buffer->drops += lost;
+            head = cb_advance(buffer, head, lost);
+            n -= lost;
+        }
+    }
+
+    CB_RELEASE();
+    buffer->head = cb_advance(buffer, head, n);
+    return n;
+}
+
+/**
+ * @brief Get the free space as up to two regions to fill in place (producer side).
+ *
+ * @param buffer Pointer to the buffer.
+ * @param span Array of two regions; span[1] is used when the free space wraps.
+ * @return uint32_t Total number of free slots.
+ */
+uint32_t CB_Reserve(CircularBuffer *buffer, CB_Span span[2]) {
+    uint32_t tail = buffer->tail;
+    uint32_t used = cb_distance(buffer, buffer->head, tail);
+    CB_ACQUIRE();
+    uint32_t free = (used < buffer->size - 1u) ? buffer->size - 1u - used : 0;
+    cb_split(buffer, tail, free, span);
+    return free;
+}
+
+/**
+ * @brief Publish n elements written into the regions returned by CB_Reserve.
+ *
+ * @param buffer Pointer to the buffer.
+ * @param n Number of elements written, at most the value returned by CB_Reserve.
+ */
+void CB_Commit(CircularBuffer *buffer, uint32_t n) {
+    uint32_t tail = buffer->tail;
+    CB_RELEASE();
+    buffer->tail = cb_advance(buffer, tail, n);
+
+    uint32_t used = cb_distance(buffer, buffer->head, buffer->tail);
+    if (used > buffer->size - 1u) used = buffer->size - 1u;
+    if (used > buffer->high_water) {
+        buffer->high_water = used;
+    }
+}
+
+/**
+ * @brief Get the stored elements as up to two regions to read in place (consumer side).
+ *
+ * @param buffer Pointer to the buffer.
+ * @param span Array of two regions, oldest elements first.
+ * @return uint32_t Total number of readable elements.
+ */
+uint32_t CB_Peek(CircularBuffer *buffer, CB_Span span[2]) {
+    uint32_t used;
+    uint32_t head = cb_consumer_head(buffer, &used);
+    CB_ACQUIRE();
+    cb_split(buffer, head, used, span);
+    return used;
+}
+
+/**
+ * @brief Release n elements returned by CB_Peek.
+ *
+ * @param buffer Pointer to the buffer.
+ * @param n Number of elements to release.
+ * @return uint8_t 1 if the peeked data stayed intact, 0 if the producer
+ *         overwrote part of it meanwhile (CB_OVERWRITE only).
+ */
+uint8_t CB_Consume(CircularBuffer *buffer, uint32_t n) {
+    uint32_t head = buffer->head;
+    uint8_t intact = 1;
+
+    if (buffer->policy != CB_REJECT) {
+        CB_ACQUIRE(); // Reads of the peeked data happen before the check
+        intact = cb_distance(buffer, head, buffer->tail) < buffer->size;
+    }
+
+    CB_RELEASE();
+    buffer->head = cb_advance(buffer, head, n);
+    return intact;
+}
+
+/**
+ * @brief Get the number of elements currently stored.
+ *
+ * @param buffer Pointer to the buffer.
+ * @return uint32_t Number of elements, at most size - 1.
+ */
+uint32_t CB_Count(const CircularBuffer *buffer) {
+    uint32_t count;
+    cb_oldest(buffer, &count);
+    return count;
+}
+
+/**
+ * @brief Get the stored elements as up to two read-only regions, oldest first.
+ *
+ * @param buffer Pointer to the buffer.
+ * @param span Array of two regions; span[1].count is 0 when the data does not wrap.
+ * @return uint32_t Total number of elements.
+ */
+uint32_t CB_View(const CircularBuffer *buffer, CB_Span span[2]) {
+    uint32_t count;
+    uint32_t head = cb_oldest(buffer, &count);
+    CB_ACQUIRE();
+    cb_split(buffer, head, count, span);
+    return count;
+}
+
 /**
  * @brief Calculate the maximum difference between consecutive elements.
  *
@@ -67,16 +433,19 @@ uint8_t CB_Pop(CircularBuffer *buffer, void *item) {
  */
 uint32_t CB_Diff(CircularBuffer *buffer, uint32_t (*compare)(const void*, const void*)) {
     uint32_t maxDiff = 0;
-    if(buffer->head != buffer->tail) {
-        uint8_t i = buffer->head;
-        uint8_t j = (buffer->head + 1) % buffer->size;
-        do {
-            uint32_t diff = compare((char*)buffer->data + (i * buffer->item_size),
-                                    (char*)buffer->data + (j * buffer->item_size));
-            if(diff > maxDiff) maxDiff = diff;
-            i = (i + 1) % buffer->size;
-            j = (j + 1) % buffer->size;
-        } while(i != buffer->tail);
+    const char *prev = NULL;
+    CB_Span span[2];
+    CB_View(buffer, span);
+
+    for (uint8_t s = 0; s < 2; s++) {
+        const char *p = span[s].ptr;
+        for (uint32_t n = span[s].count; n > 0; n--, p += buffer->item_size) {
+            if (prev != NULL) {
+                uint32_t diff = compare(prev, p);
+                if(diff > maxDiff) maxDiff = diff;
+            }
+            prev = p;
+        }
     }
     return maxDiff;
 }
@@ -90,17 +459,17 @@ uint32_t CB_Diff(CircularBuffer *buffer, uint32_t (*compare)(const void*, const
  * @return uint32_t Average value of the elements.
  */
 uint32_t CB_Average(CircularBuffer *buffer, uint32_t (*sum)(const void*, const void*), uint32_t (*divide)(const void*, uint32_t)) {
-    if(buffer->head == buffer->tail) return 0; // No elements
+    CB_Span span[2];
+    uint32_t count = CB_View(buffer, span);
+    if(count == 0) return 0; // No elements
 
     uint32_t total = 0;
-    uint32_t count = 0;
-    uint8_t i = buffer->head;
-
-    do {
-        total = sum(&total, (char*)buffer->data + (i * buffer->item_size));
-        count++;
-        i = (i + 1) % buffer->size;
-    } while(i != buffer->tail);
+    for (uint8_t s = 0; s < 2; s++) {
+        const char *p = span[s].ptr;
+        for (uint32_t n = span[s].count; n > 0; n--, p += buffer->item_size) {
+            total = sum(&total, p);
+        }
+    }
 
     return divide(&total, count);
 }
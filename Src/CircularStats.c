@@ -0,0 +1,165 @@
+/**
+ * @file CircularStats.c
+ * @brief Implementation of the sliding window with O(1) running statistics.
+ */
+
+#include "CircularStats.h"
+
+static inline uint16_t cbs_next(const CBS_Window *w, uint16_t i) {
+    return (++i == w->size) ? 0 : i;
+}
+
+static inline uint16_t cbs_prev(const CBS_Window *w, uint16_t i) {
+    return (i == 0) ? w->size - 1 : i - 1;
+}
+
+static inline uint32_t cbs_delta(const CBS_Window *w, uint16_t slot) {
+    int32_t d = w->samples[slot] - w->samples[cbs_prev(w, slot)];
+    return (d < 0) ? -(uint32_t)d : (uint32_t)d;
+}
+
+static inline uint16_t dq_front(const CBS_Deque *q) {
+    return q->slot[q->head];
+}
+
+static inline uint16_t dq_back(const CBS_Window *w, const CBS_Deque *q) {
+    uint32_t i = q->head + q->count - 1u;
+    return q->slot[(i >= w->size) ? i - w->size : i];
+}
+
+static inline void dq_push_back(const CBS_Window *w, CBS_Deque *q, uint16_t slot) {
+    uint32_t i = q->head + q->count;
+    q->slot[(i >= w->size) ? i - w->size : i] = slot;
+    q->count++;
+}
+
+static inline void dq_pop_front(const CBS_Window *w, CBS_Deque *q) {
+    q->head = cbs_next(w, q->head);
+    q->count--;
+}
+
+/** Drop the front entry if it refers to the slot leaving the window. */
+static inline void dq_expire(const CBS_Window *w, CBS_Deque *q, uint16_t slot) {
+    if (q->count && dq_front(q) == slot) {
+        dq_pop_front(w, q);
+    }
+}
+
+/**
+ * @brief Initialize an empty window.
+ *
+ * @param w Pointer to the window.
+ * @param storage Memory of CBS_STORAGE_WORDS(size) words.
+ * @param size Window length in samples (1..65535).
+ */
+void CBS_Init(CBS_Window *w, uint32_t *storage, uint16_t size) {
+    uint16_t *slots = (uint16_t*)(storage + size);
+
+    w->samples = (int32_t*)storage;
+    w->size = size;
+    w->oldest = 0;
+    w->count = 0;
+    w->sum = 0;
+    w->sum_sq = 0;
+    w->min = (CBS_Deque){ .slot = slots, .head = 0, .count = 0 };
+    w->max = (CBS_Deque){ .slot = slots + size, .head = 0, .count = 0 };
+    w->delta = (CBS_Deque){ .slot = slots + 2u * size, .head = 0, .count = 0 };
+}
+
+/**
+ * @brief Add a sample, evicting the oldest one when the window is full.
+ *
+ * @param w Pointer to the window.
+ * @param x New sample.
+ */
+void CBS_Push(CBS_Window *w, int32_t x) {
+    // Evict the oldest sample and the delta that pairs it with its successor
+    if (w->count == w->size) {
+        uint16_t o = w->oldest;
+        int32_t v = w->samples[o];
+        w->sum -= v;
+        w->sum_sq -= (uint64_t)((int64_t)v * v);
+        dq_expire(w, &w->min, o);
+        dq_expire(w, &w->max, o);
+        w->oldest = cbs_next(w, o);
+        dq_expire(w, &w->delta, w->oldest);
+        w->count--;
+    }
+
+    uint32_t s32 = (uint32_t)w->oldest + w->count;
+    uint16_t s = (s32 >= w->size) ? s32 - w->size : s32;
+    w->samples[s] = x;
+    w->sum += x;
+    w->sum_sq += (uint64_t)((int64_t)x * x);
+
+    while (w->min.count && w->samples[dq_back(w, &w->min)] >= x) w->min.count--;
+    dq_push_back(w, &w->min, s);
+    while (w->max.count && w->samples[dq_back(w, &w->max)] <= x) w->max.count--;
+    dq_push_back(w, &w->max, s);
+
+    if (w->count > 0) {
+        uint32_t d = cbs_delta(w, s);
+        while (w->delta.count && cbs_delta(w, dq_back(w, &w->delta)) <= d) w->delta.count--;
+        dq_push_back(w, &w->delta, s);
+    }
+    w->count++;
+}
+
+/**
+ * @brief Arithmetic mean of the window, 0 when empty.
+ *
+ * @param w Pointer to the window.
+ * @return float Mean value.
+ */
+float CBS_Mean(const CBS_Window *w) {
+    if (w->count == 0) return 0.0f;
+    return (float)w->sum / (float)w->count;
+}
+
+/**
+ * @brief Population variance of the window, 0 when empty.
+ *
+ * @param w Pointer to the window.
+ * @return float Variance.
+ */
+float CBS_Variance(const CBS_Window *w) {
+    if (w->count == 0) return 0.0f;
+    // n^2 * var = n * sum(x^2) - sum(x)^2 overflows long before sum(x^2) does.
+    // With |sum| = q * n + r it equals n * (sum_sq - q * |sum|) - r * |sum|, where
+    // q * |sum| <= sum_sq and r * |sum| < n * |sum|, so n * var = e - rem / n exactly.
+    uint64_t n = w->count;
+    uint64_t a = (uint64_t)((w->sum < 0) ? -w->sum : w->sum);
+    uint64_t ra = (a % n) * a;
+    uint64_t e = w->sum_sq - (a / n) * a - ra / n;
+    return ((float)e - (float)(ra % n) / (float)n) / (float)n;
+}
+
+/**
+ * @brief Smallest sample in the window, 0 when empty.
+ *
+ * @param w Pointer to the window.
+ * @return int32_t Minimum.
+ */
+int32_t CBS_Min(const CBS_Window *w) {
+    return w->min.count ? w->samples[dq_front(&w->min)] : 0;
+}
+
+/**
+ * @brief Largest sample in the window, 0 when empty.
+ *
+ * @param w Pointer to the window.
+ * @return int32_t Maximum.
+ */
+int32_t CBS_Max(const CBS_Window *w) {
+    return w->max.count ? w->samples[dq_front(&w->max)] : 0;
+}
+
+/**
+ * @brief Largest absolute difference between consecutive samples, 0 if fewer than two.
+ *
+ * @param w Pointer to the window.
+ * @return uint32_t Maximum delta.
+ */
+uint32_t CBS_MaxDelta(const CBS_Window *w) {
+    return w->delta.count ? cbs_delta(w, dq_front(&w->delta)) : 0;
+}
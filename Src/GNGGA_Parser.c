@@ -191,11 +191,38 @@ void GNGGA_Init(GNGGA_Parser *p, UART_HandleTypeDef *huart) {
 	p->data.finish = false;
 	p->rxBuf.size = GNGGA_BUFFER_CAPACITY;
 	p->rxBuf.item_size = sizeof(p->rxData);
+	p->rxBuf.policy = CB_REJECT;  // Keep the bytes already queued, count the ones lost
 
-	CB_Init(&p->rxBuf);
+	CB_InitStatic(&p->rxBuf, p->rxStorage);
 	HAL_UART_Receive_IT(p->huart, &p->rxData, 1);  // Start UART reception in interrupt mode
 }
 
+/**
+ * @brief Feed one character into the parser state machine
+ *
+ * @param p Pointer to the parser instance
+ * @param c Current character being processed
+ */
+static void process_char(GNGGA_Parser *p, uint8_t c) {
+	switch (p->state) {
+		case STATE_IDLE:
+			idle_state(p, c);
+			break;
+		case STATE_PARSE_TIME:
+			parse_time_state(p, c);
+			break;
+		case STATE_PARSE_LATLON:
+			parse_latlon_state(p, c);
+			break;
+		case STATE_PARSE_INTS:
+			parse_ints_state(p, c);
+			break;
+		case STATE_PARSE_FLOATS:
+			parse_floats_state(p, c);
+			break;
+	}
+}
+
 /**
  * @brief Main processing loop for the parser state machine
  *
@@ -204,28 +231,17 @@ void GNGGA_Init(GNGGA_Parser *p, UART_HandleTypeDef *huart) {
  * @note This function should be called periodically to process received data
  */
 void GNGGA_Loop(GNGGA_Parser *p) {
-	uint8_t c;
+	CB_Span span[2];
 	if (!p->newData)
 		return;
-	while (CB_Pop(&p->rxBuf, &c)) {  // Process all available characters in buffer
-		switch (p->state) {
-			case STATE_IDLE:
-				idle_state(p, c);
-				break;
-			case STATE_PARSE_TIME:
-				parse_time_state(p, c);
-				break;
-			case STATE_PARSE_LATLON:
-				parse_latlon_state(p, c);
-				break;
-			case STATE_PARSE_INTS:
-				parse_ints_state(p, c);
-				break;
-			case STATE_PARSE_FLOATS:
-				parse_floats_state(p, c);
-				break;
+	uint32_t count = CB_Peek(&p->rxBuf, span);  // Process all available characters in place
+	for (uint8_t s = 0; s < 2; s++) {
+		const uint8_t *c = span[s].ptr;
+		for (uint32_t n = span[s].count; n > 0; n--) {
+			process_char(p, *c++);
 		}
 	}
+	CB_Consume(&p->rxBuf, count);
 }
 
 /**
@@ -0,0 +1,151 @@
+/**
+ * @file MPSCRing.c
+ * @brief Implementation of the lock-free multi-producer/single-consumer ring.
+ *
+ * Bounded queue with one sequence number per slot. A free slot for position
+ * p holds seq == p, a published one seq == p + 1, and the consumer hands it
+ * back for the next lap with seq == p + slots.
+ */
+
+#include "MPSCRing.h"
+#include <string.h>
+
+static inline _Atomic uint32_t *mpsc_seq(const MPSC_Ring *r, uint32_t pos) {
+    return (_Atomic uint32_t*)(r->slots + (pos & r->mask) * r->stride);
+}
+
+static inline void *mpsc_item(const MPSC_Ring *r, uint32_t pos) {
+    return r->slots + (pos & r->mask) * r->stride + 4u;
+}
+
+/**
+ * @brief Initialize the ring over caller-provided storage.
+ *
+ * @param r Pointer to the ring.
+ * @param storage MPSC_STORAGE_WORDS(slots, item_size) words.
+ * @param slots Number of slots, a power of two, at least 2.
+ * @param item_size Size of one item in bytes.
+ * @return uint8_t 1 on success, 0 if @p slots is not a power of two >= 2.
+ */
+uint8_t MPSC_Init(MPSC_Ring *r, uint32_t *storage, uint32_t slots, uint16_t item_size) {
+    // One slot would publish an item with the sequence that frees it for the next lap
+    if (slots < 2 || (slots & (slots - 1u)) != 0) {
+        return 0;
+    }
+    r->slots = (uint8_t*)storage;
+    r->mask = slots - 1u;
+    r->item_size = item_size;
+    r->stride = MPSC_STRIDE(item_size);
+    r->head = 0;
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->drops, 0);
+
+    for (uint32_t i = 0; i < slots; i++) {
+        atomic_init(mpsc_seq(r, i), i);
+    }
+    return 1;
+}
+
+/**
+ * @brief Reserve a slot to fill in place (any producer, ISR-safe).
+ *
+ * @param r Pointer to the ring.
+ * @param ticket Receives the position to pass to MPSC_Commit.
+ * @return void* Item memory, NULL if the ring is full (counted in drops).
+ */
+void *MPSC_Reserve(MPSC_Ring *r, uint32_t *ticket) {
+    uint32_t pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(mpsc_seq(r, pos), memory_order_acquire);
+        int32_t dif = (int32_t)(seq - pos);
+
+        if (dif == 0) {
+            // Slot is free for this lap, try to claim the position
+            if (atomic_compare_exchange_weak_explicit(&r->tail, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            // Consumer has not released this slot yet: full
+            atomic_fetch_add_explicit(&r->drops, 1, memory_order_relaxed);
+            return NULL;
+        } else {
+            // Another producer took it, retry with the current tail
+            pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        }
+    }
+
+    *ticket = pos;
+    return mpsc_item(r, pos);
+}
+
+/**
+ * @brief Publish a slot obtained with MPSC_Reserve.
+ *
+ * @param r Pointer to the ring.
+ * @param ticket Position returned by MPSC_Reserve.
+ */
+void MPSC_Commit(MPSC_Ring *r, uint32_t ticket) {
+    atomic_store_explicit(mpsc_seq(r, ticket), ticket + 1, memory_order_release);
+}
+
+/**
+ * @brief Copy an item into the ring (any producer, ISR-safe).
+ *
+ * @param r Pointer to the ring.
+ * @param item Pointer to the item.
+ * @return uint8_t 1 if queued, 0 if the ring is full.
+ */
+uint8_t MPSC_Push(MPSC_Ring *r, const void *item) {
+    uint32_t ticket;
+    void *slot = MPSC_Reserve(r, &ticket);
+    if (slot == NULL) {
+        return 0;
+    }
+    memcpy(slot, item, r->item_size);
+    MPSC_Commit(r, ticket);
+    return 1;
+}
+
+/**
+ * @brief Get the oldest published item in place (consumer only).
+ *
+ * @param r Pointer to the ring.
+ * @return void* Item memory, NULL if nothing is published yet.
+ */
+void *MPSC_Peek(MPSC_Ring *r) {
+    uint32_t seq = atomic_load_explicit(mpsc_seq(r, r->head), memory_order_acquire);
+    if (seq != r->head + 1) {
+        return NULL;
+    }
+    return mpsc_item(r, r->head);
+}
+
+/**
+ * @brief Release the item returned by MPSC_Peek (consumer only).
+ *
+ * @param r Pointer to the ring.
+ */
+void MPSC_Release(MPSC_Ring *r) {
+    // Hand the slot to the producers of the next lap
+    atomic_store_explicit(mpsc_seq(r, r->head), r->head + r->mask + 1u, memory_order_release);
+    r->head++;
+}
+
+/**
+ * @brief Copy the oldest published item out of the ring (consumer only).
+ *
+ * @param r Pointer to the ring.
+ * @param item Pointer to store the item.
+ * @return uint8_t 1 if an item was popped, 0 if none is published.
+ */
+uint8_t MPSC_Pop(MPSC_Ring *r, void *item) {
+    void *slot = MPSC_Peek(r);
+    if (slot == NULL) {
+        return 0;
+    }
+    memcpy(item, slot, r->item_size);
+    MPSC_Release(r);
+    return 1;
+}
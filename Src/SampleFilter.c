@@ -0,0 +1,164 @@
+/**
+ * @file SampleFilter.c
+ * @brief Implementation of the windowed filter kernels.
+ *
+ * The moving average, median and FIR bodies are shared through
+ * SampleFilter_impl.h, instantiated once per sample type.
+ */
+
+#include "SampleFilter.h"
+#include <string.h>
+
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#endif
+
+static inline int16_t sf_sat16(int64_t v) {
+    return (v > INT16_MAX) ? INT16_MAX : (v < INT16_MIN) ? INT16_MIN : (int16_t)v;
+}
+
+static inline int32_t sf_sat32(int64_t v) {
+    return (v > INT32_MAX) ? INT32_MAX : (v < INT32_MIN) ? INT32_MIN : (int32_t)v;
+}
+
+_Static_assert(SF_MEDIAN_MAX_SIZE <= INT16_MAX, "median heap slots are stored as int16_t");
+
+/** Round a Q15 accumulator to an integer sample. */
+#define SF_Q_ROUND(a) (((a) + (1 << (SF_FIR_Q - 1))) >> SF_FIR_Q)
+
+/* int16_t */
+#define SF_T        int16_t
+#define SF_S        i16
+#define SF_ACC      int32_t
+#define SF_COEF     int16_t
+#define SF_DOT_ACC  int64_t
+#define SF_OUT(a)   sf_sat16(SF_Q_ROUND(a))
+#define SF_MID(a,b) ((int16_t)(((int32_t)(a) + (b)) / 2))
+#define SF_MA_RESUM 0
+#if defined(__ARM_FEATURE_DSP)
+#define SF_USE_SMLALD 1
+#else
+#define SF_USE_SMLALD 0
+#endif
+#include "SampleFilter_impl.h"
+#undef SF_T
+#undef SF_S
+#undef SF_ACC
+#undef SF_COEF
+#undef SF_DOT_ACC
+#undef SF_OUT
+#undef SF_MID
+#undef SF_MA_RESUM
+#undef SF_USE_SMLALD
+
+/* int32_t */
+#define SF_T        int32_t
+#define SF_S        i32
+#define SF_ACC      int64_t
+#define SF_COEF     int16_t
+#define SF_DOT_ACC  int64_t
+#define SF_OUT(a)   sf_sat32(SF_Q_ROUND(a))
+#define SF_MID(a,b) ((int32_t)(((int64_t)(a) + (b)) / 2))
+#define SF_MA_RESUM 0
+#define SF_USE_SMLALD 0
+#include "SampleFilter_impl.h"
+#undef SF_T
+#undef SF_S
+#undef SF_ACC
+#undef SF_COEF
+#undef SF_DOT_ACC
+#undef SF_OUT
+#undef SF_MID
+#undef SF_MA_RESUM
+#undef SF_USE_SMLALD
+
+/* float */
+#define SF_T        float
+#define SF_S        f32
+#define SF_ACC      float
+#define SF_COEF     float
+#define SF_DOT_ACC  float
+#define SF_OUT(a)   (a)
+#define SF_MID(a,b) (((a) + (b)) * 0.5f)
+#define SF_MA_RESUM 1
+#define SF_USE_SMLALD 0
+#include "SampleFilter_impl.h"
+#undef SF_T
+#undef SF_S
+#undef SF_ACC
+#undef SF_COEF
+#undef SF_DOT_ACC
+#undef SF_OUT
+#undef SF_MID
+#undef SF_MA_RESUM
+#undef SF_USE_SMLALD
+
+/**
+ * @brief Initialize an integer EMA with alpha = 2^-shift.
+ *
+ * @param f Pointer to the filter.
+ * @param shift Smoothing shift (0..15).
+ */
+void SF_EMA_Init_i16(SF_EMA_i16 *f, uint8_t shift) {
+    f->acc = 0;
+    f->shift = shift;
+    f->primed = 0;
+}
+
+void SF_EMA_Init_i32(SF_EMA_i32 *f, uint8_t shift) {
+    f->acc = 0;
+    f->shift = shift;
+    f->primed = 0;
+}
+
+/**
+ * @brief Initialize a float EMA.
+ *
+ * @param f Pointer to the filter.
+ * @param alpha Smoothing factor in (0, 1].
+ */
+void SF_EMA_Init_f32(SF_EMA_f32 *f, float alpha) {
+    f->acc = 0.0f;
+    f->alpha = alpha;
+    f->primed = 0;
+}
+
+/**
+ * @brief Feed a sample to the EMA.
+ *
+ * The state is kept scaled by 2^shift, so one add, one subtract and one
+ * shift per sample. The first sample initializes the state.
+ *
+ * @param f Pointer to the filter.
+ * @param x New sample.
+ * @return Filtered value.
+ */
+int16_t SF_EMA_Push_i16(SF_EMA_i16 *f, int16_t x) {
+    if (!f->primed) {
+        f->acc = (int32_t)x * (1 << f->shift);
+        f->primed = 1;
+    } else {
+        f->acc += x - (f->acc >> f->shift);
+    }
+    return (int16_t)(f->acc >> f->shift);
+}
+
+int32_t SF_EMA_Push_i32(SF_EMA_i32 *f, int32_t x) {
+    if (!f->primed) {
+        f->acc = (int64_t)x * (1 << f->shift);
+        f->primed = 1;
+    } else {
+        f->acc += x - (f->acc >> f->shift);
+    }
+    return (int32_t)(f->acc >> f->shift);
+}
+
+float SF_EMA_Push_f32(SF_EMA_f32 *f, float x) {
+    if (!f->primed) {
+        f->acc = x;
+        f->primed = 1;
+    } else {
+        f->acc += f->alpha * (x - f->acc);
+    }
+    return f->acc;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file SampleFilter_impl.h
+ * @brief Type-generic body of the SampleFilter kernels.
+ *
+ * Included by SampleFilter.c once per sample type with the following macros set:
+ *  - SF_T        sample type
+ *  - SF_S        name suffix (i16, i32, f32)
+ *  - SF_ACC      moving average accumulator type
+ *  - SF_COEF     FIR coefficient type
+ *  - SF_DOT_ACC  FIR accumulator type
+ *  - SF_OUT(a)   convert a FIR accumulator to SF_T (scale, round, saturate)
+ *  - SF_MID(a,b) mean of two samples for even-length medians
+ *  - SF_MA_RESUM 1 to rebuild the moving average sum once per window (float drift)
+ */
+
+#define SF_CAT_(a, b) a##_##b
+#define SF_CAT(a, b) SF_CAT_(a, b)
+#define SF_FN(base) SF_CAT(base, SF_S)
+#define SF_TYPE(base) SF_CAT(base, SF_S)
+
+/* ---------------------------------------------------------------- Moving average */
+
+uint8_t SF_FN(SF_MA_Init)(SF_TYPE(SF_MA) *f, SF_T *buf, uint16_t size) {
+    if (size == 0) {
+        return 0; // Empty window, Push would divide by zero
+    }
+    f->buf = buf;
+    f->size = size;
+    f->pos = 0;
+    f->count = 0;
+    f->sum = 0;
+    return 1;
+}
+
+SF_T SF_FN(SF_MA_Push)(SF_TYPE(SF_MA) *f, SF_T x) {
+    if (f->count == f->size) {
+        f->sum -= f->buf[f->pos];
+    } else {
+        f->count++;
+    }
+    f->sum += x;
+    f->buf[f->pos] = x;
+
+    if (++f->pos == f->size) {
+        f->pos = 0;
+#if SF_MA_RESUM
+        if (f->count == f->size) {
+            SF_ACC sum = 0;
+            for (uint16_t i = 0; i < f->size; i++) sum += f->buf[i];
+            f->sum = sum;
+        }
+#endif
+    }
+    return (SF_T)(f->sum / f->count);
+}
+
+/* ---------------------------------------------------------------- Running median */
+
+#define SF_LESS(f, i, j) ((f)->data[(f)->heap[i]] < (f)->data[(f)->heap[j]])
+#define SF_MIN_CT(f) (((int)(f)->count - 1) / 2)
+#define SF_MAX_CT(f) ((int)(f)->count / 2)
+
+static inline int SF_FN(sf_med_exchange)(SF_TYPE(SF_Median) *f, int i, int j) {
+    int16_t t = f->heap[i];
+    f->heap[i] = f->heap[j];
+    f->heap[j] = t;
+    f->pos[f->heap[i]] = i;
+    f->pos[f->heap[j]] = j;
+    return 1;
+}
+
+/** Swap heap entries i and j if data[i] < data[j]. */
+static inline int SF_FN(sf_med_cmp_exch)(SF_TYPE(SF_Median) *f, int i, int j) {
+    return SF_LESS(f, i, j) && SF_FN(sf_med_exchange)(f, i, j);
+}
+
+/** Restore the min-heap below i / 2, i is the first child to check (1 checks against the median). */
+static void SF_FN(sf_min_sort_down)(SF_TYPE(SF_Median) *f, int i) {
+    for (; i <= SF_MIN_CT(f); i *= 2) {
+        if (i > 1 && i < SF_MIN_CT(f) && SF_LESS(f, i + 1, i)) ++i;
+        if (!SF_FN(sf_med_cmp_exch)(f, i, i / 2)) break;
+    }
+}
+
+/** Restore the max-heap below i / 2, i is the first child to check (-1 checks against the median). */
+static void SF_FN(sf_max_sort_down)(SF_TYPE(SF_Median) *f, int i) {
+    for (; i >= -SF_MAX_CT(f); i *= 2) {
+        if (i < -1 && i > -SF_MAX_CT(f) && SF_LESS(f, i, i - 1)) --i;
+        if (!SF_FN(sf_med_cmp_exch)(f, i / 2, i)) break;
+    }
+}
+
+/** Returns 1 if the entry reached the median position. */
+static int SF_FN(sf_min_sort_up)(SF_TYPE(SF_Median) *f, int *i) {
+    while (*i > 0 && SF_FN(sf_med_cmp_exch)(f, *i, *i / 2)) *i /= 2;
+    return *i == 0;
+}
+
+static int SF_FN(sf_max_sort_up)(SF_TYPE(SF_Median) *f, int *i) {
+    while (*i < 0 && SF_FN(sf_med_cmp_exch)(f, *i / 2, *i)) *i /= 2;
+    return *i == 0;
+}
+
+uint8_t SF_FN(SF_Median_Init)(SF_TYPE(SF_Median) *f, SF_T *data, int16_t *index, uint16_t size) {
+    if (size == 0 || size > SF_MEDIAN_MAX_SIZE) {
+        return 0; // Empty window, or slots that do not fit in int16_t
+    }
+    f->data = data;
+    f->pos = index;
+    f->heap = index + size + size / 2;
+    f->size = size;
+    f->idx = 0;
+    f->count = 0;
+
+    // Fill pattern: median, max, min, max, min, ...
+    for (int i = size - 1; i >= 0; i--) {
+        f->pos[i] = ((i + 1) / 2) * ((i & 1) ? -1 : 1);
+        f->heap[f->pos[i]] = i;
+    }
+    return 1;
+}
+
+SF_T SF_FN(SF_Median_Push)(SF_TYPE(SF_Median) *f, SF_T x) {
+    int is_new = f->count < f->size;
+    int p = f->pos[f->idx];
+    SF_T old = f->data[f->idx];
+
+    f->data[f->idx] = x;
+    if (++f->idx == f->size) f->idx = 0;
+    f->count += is_new;
+
+    if (p > 0) {
+        // Slot is in the min-heap
+        if (!is_new && old < x) SF_FN(sf_min_sort_down)(f, p * 2);
+        else if (SF_FN(sf_min_sort_up)(f, &p)) SF_FN(sf_max_sort_down)(f, -1);
+    } else if (p < 0) {
+        // Slot is in the max-heap
+        if (!is_new && x < old) SF_FN(sf_max_sort_down)(f, p * 2);
+        else if (SF_FN(sf_max_sort_up)(f, &p)) SF_FN(sf_min_sort_down)(f, 1);
+    } else {
+        // Slot is the median
+        if (SF_MAX_CT(f)) SF_FN(sf_max_sort_down)(f, -1);
+        if (SF_MIN_CT(f)) SF_FN(sf_min_sort_down)(f, 1);
+    }
+
+    SF_T m = f->data[f->heap[0]];
+    if ((f->count & 1) == 0) {
+        m = SF_MID(m, f->data[f->heap[-1]]);
+    }
+    return m;
+}
+
+#undef SF_LESS
+#undef SF_MIN_CT
+#undef SF_MAX_CT
+
+/* ---------------------------------------------------------------- Decimating FIR */
+
+void SF_FN(SF_FIR_Init)(SF_TYPE(SF_FIR) *f, const SF_COEF *coeffs, SF_T *hist, uint16_t taps, uint16_t decim) {
+    f->coeffs = coeffs;
+    f->hist = hist;
+    f->taps = taps;
+    f->pos = taps - 1;
+    f->decim = decim ? decim : 1;
+    f->phase = f->decim;
+    for (uint32_t i = 0; i < 2u * taps; i++) hist[i] = 0;
+}
+
+/** Dot product of the contiguous window with the coefficients. */
+static inline SF_DOT_ACC SF_FN(sf_dot)(const SF_T *x, const SF_COEF *h, uint16_t n) {
+    SF_DOT_ACC acc = 0;
+#if SF_USE_SMLALD
+    // Two 16x16 MACs per instruction, unaligned word loads are fine on M4/M7
+    for (; n >= 2; n -= 2, x += 2, h += 2) {
+        int32_t xx, hh;
+        memcpy(&xx, x, 4);
+        memcpy(&hh, h, 4);
+        acc = __smlald(xx, hh, acc);
+    }
+#endif
+    for (uint16_t i = 0; i < n; i++) {
+        acc += (SF_DOT_ACC)x[i] * h[i];
+    }
+    return acc;
+}
+
+static inline uint8_t SF_FN(sf_fir_step)(SF_TYPE(SF_FIR) *f, SF_T x, SF_T *out) {
+    uint16_t p = (f->pos + 1 == f->taps) ? 0 : f->pos + 1;
+    f->pos = p;
+    f->hist[p] = x;
+    f->hist[p + f->taps] = x;
+
+    if (--f->phase) return 0;
+    f->phase = f->decim;
+    // Oldest to newest sample is hist[p + 1] .. hist[p + taps]
+    *out = SF_OUT(SF_FN(sf_dot)(&f->hist[p + 1], f->coeffs, f->taps));
+    return 1;
+}
+
+uint8_t SF_FN(SF_FIR_Push)(SF_TYPE(SF_FIR) *f, SF_T x, SF_T *out) {
+    return SF_FN(sf_fir_step)(f, x, out);
+}
+
+uint32_t SF_FN(SF_FIR_Process)(SF_TYPE(SF_FIR) *f, const SF_T *in, uint32_t n, SF_T *out) {
+    uint32_t produced = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        produced += SF_FN(sf_fir_step)(f, in[i], &out[produced]);
+    }
+    return produced;
+}
+
+#undef SF_CAT_
+#undef SF_CAT
+#undef SF_FN
+#undef SF_TYPE
@@ -7,37 +7,63 @@
  */
 
 #include "SysLog.h"
+#include "W25Qx.h"
 #include "cmsis_os.h"
 #include "task.h"
 #include "stdarg.h"
 #include "stdio.h"
+#include "stdlib.h"
 #include "stdint.h"
 #include "stdbool.h"
+#include "string.h"
 #include "lwip.h"
 #include "lwip/sockets.h"
 #include "fatfs.h"
 #include "FreeRTOS.h"
-#include "queue.h"
+#include "stdatomic.h"
 
-/** Task and Queue creation macros */
-#define LOG_CREATE_SWV() xTaskCreate(LogTask_SWV, "LogSWV", 128, NULL, osPriorityNormal, &LogSWV_Handle); \
-                         swvQueue = xQueueCreate(LOG_QUEUE_LENGTH, MAX_LOG_MESSAGE_SIZE);
+/** SWV task stack in words */
+#if SYS_LOG_BINARY
+#define LOG_SWV_STACK 384   // The SWV task renders records with snprintf
+#else
+#define LOG_SWV_STACK 128
+#endif
 
-#define LOG_CREATE_UDP() xTaskCreate(LogTask_UDP, "LogUDP", 448, NULL, osPriorityNormal, &LogUDP_Handle); \
-                         udpQueue = xQueueCreate(LOG_QUEUE_LENGTH, MAX_LOG_MESSAGE_SIZE);
+/** Record states */
+#define LOG_REC_RESERVED  0   /*!< Being written, readers stop here */
+#define LOG_REC_READY     1   /*!< Complete, readable */
+#define LOG_REC_PAD       2   /*!< Filler up to the end of the arena */
 
-#define LOG_CREATE_MMC() xTaskCreate(LogTask_eMMC, "LogMMC", 544, NULL, osPriorityNormal, &LogMMC_Handle); \
-                         mmcQueue = xQueueCreate(LOG_QUEUE_LENGTH, MAX_LOG_MESSAGE_SIZE);
+#define LOG_ARENA_MASK (LOG_ARENA_SIZE - 1u)
+#define LOG_REC_TOTAL(size) ((sizeof(log_rec_t) + (size) + 1u + 3u) & ~3u)
 
-/** Task and Queue deletion macros */
-#define LOG_DELETE_SWV() vTaskDelete(LogSWV_Handle); \
-                         vQueueDelete(swvQueue);
+/**
+ * @brief Header of a record in the arena, followed by the payload and a NUL.
+ */
+typedef struct {
+    uint16_t size;                   /*!< Payload bytes (text length or binary record size) */
+    volatile uint8_t pending;        /*!< Sinks that still have to consume the record */
+    volatile uint8_t state;          /*!< LOG_REC_RESERVED, LOG_REC_READY or LOG_REC_PAD */
+    uint8_t level;                   /*!< sys_log_level_t of the message */
+    uint8_t sinks;                   /*!< Sinks that output the record, the others only release it */
+    uint8_t reserved[2];             /*!< Keeps the payload word aligned */
+} log_rec_t;
 
-#define LOG_DELETE_UDP() vTaskDelete(LogUDP_Handle); \
-                         vQueueDelete(udpQueue);
+/**
+ * @brief Per-sink reader state.
+ */
+typedef struct {
+    TaskHandle_t task;               /*!< Sink task, NULL when the sink is off */
+    uint32_t cursor;                 /*!< Running index of the next record to read */
+} log_sink_t;
 
-#define LOG_DELETE_MMC() vTaskDelete(LogMMC_Handle); \
-                         vQueueDelete(mmcQueue);
+/**
+ * @brief Runtime level of one tag, keyed by the address of the tag string.
+ */
+typedef struct {
+    const char *volatile tag;        /*!< Tag string, NULL for a free slot */
+    volatile uint8_t level;          /*!< Highest level let through */
+} log_tag_level_t;
 
 /**
  * @brief Logger structure.
@@ -45,19 +71,22 @@
 typedef struct {
     uint8_t initialized;              /*!< Initialization flag */
     sys_log_settings_t settings;     /*!< Logger settings */
+    uint32_t head;                   /*!< Running index of the oldest unreleased record */
+    uint32_t tail;                   /*!< Running index of the next free byte */
+    uint8_t active;                  /*!< Mask of running sinks, copied into new records */
+    log_sink_t sinks[SYS_LOG_SINK_COUNT]; /*!< Reader state per sink (bit n of a pending mask is sink n) */
+    sys_log_drops_t drops;           /*!< Drop counters */
+    uint32_t unreported;             /*!< Drops not yet announced by a summary record */
+    uint32_t last_report;            /*!< Tick of the last summary record */
+    volatile uint8_t default_level;  /*!< Runtime level of tags without an entry */
+    volatile uint8_t sink_level[SYS_LOG_SINK_COUNT]; /*!< Highest level each sink takes */
+    log_tag_level_t tags[LOG_TAG_SLOTS]; /*!< Open-addressing hash of per-tag levels */
 } sys_logger_t;
 
 static sys_logger_t logger;
 
-/** Queues for log messages */
-static QueueHandle_t swvQueue = NULL;
-static QueueHandle_t udpQueue = NULL;
-static QueueHandle_t mmcQueue = NULL;
-
-/** Task handles */
-static TaskHandle_t LogSWV_Handle = NULL;
-static TaskHandle_t LogUDP_Handle = NULL;
-static TaskHandle_t LogMMC_Handle = NULL;
+/** Shared arena of variable-length records, read in place by every sink */
+static uint8_t logArena[LOG_ARENA_SIZE] __attribute__((aligned(4)));
 
 /**
  * @brief Thread for SWV log output.
@@ -80,6 +109,373 @@ void LogTask_UDP(void *arg);
  */
 void LogTask_eMMC(void *arg);
 
+/**
+ * @brief Thread for W25Qx flash log output.
+ *
+ * @param arg Unused parameter.
+ */
+void LogTask_Flash(void *arg);
+
+/**
+ * @brief Start the time base of sys_log_timestamp().
+ */
+static void log_clock_init(void);
+
+#if SYS_LOG_TIMESTAMP_US
+/**
+ * @brief HAL tick extended to 64 bits.
+ */
+static uint64_t log_tick64(void);
+#endif
+
+static const struct {
+    TaskFunction_t task;
+    const char *name;
+    uint16_t stack;
+} log_sink_tasks[SYS_LOG_SINK_COUNT] = {
+    [SYS_LOG_SINK_SWV] = { LogTask_SWV,  "LogSWV", LOG_SWV_STACK },
+    [SYS_LOG_SINK_UDP] = { LogTask_UDP,  "LogUDP", 448 },
+    [SYS_LOG_SINK_MMC] = { LogTask_eMMC, "LogMMC", 544 },
+    [SYS_LOG_SINK_FLASH] = { LogTask_Flash, "LogFlash", 320 },
+};
+
+static inline log_rec_t *log_rec_at(uint32_t index) {
+    return (log_rec_t*)&logArena[index & LOG_ARENA_MASK];
+}
+
+/** Enter the arena critical section from a task or, if isr is set, from an interrupt. */
+static inline UBaseType_t log_lock(uint8_t isr) {
+    if (isr) {
+        return taskENTER_CRITICAL_FROM_ISR();
+    }
+    taskENTER_CRITICAL();
+    return 0;
+}
+
+static inline void log_unlock(uint8_t isr, UBaseType_t saved) {
+    if (isr) {
+        taskEXIT_CRITICAL_FROM_ISR(saved);
+    } else {
+        taskEXIT_CRITICAL();
+    }
+}
+
+/** Release consumed records at the head. Call inside a critical section. */
+static void log_reclaim(void) {
+    while (logger.head != logger.tail) {
+        log_rec_t *rec = log_rec_at(logger.head);
+        if (rec->state == LOG_REC_RESERVED || rec->pending) break;
+        logger.head += (rec->state == LOG_REC_PAD) ? rec->size : LOG_REC_TOTAL(rec->size);
+    }
+}
+
+/**
+ * @brief Start a sink: its reader begins at the newest record.
+ *
+ * @param sink Sink index.
+ */
+static void log_sink_start(uint8_t sink) {
+    log_sink_t *s = &logger.sinks[sink];
+
+    taskENTER_CRITICAL();
+    s->cursor = logger.tail;
+    taskEXIT_CRITICAL();
+
+    if (xTaskCreate(log_sink_tasks[sink].task, log_sink_tasks[sink].name, log_sink_tasks[sink].stack,
+                    NULL, osPriorityNormal, &s->task) != pdPASS) {
+        s->task = NULL;
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    logger.active |= 1u << sink;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Stop a sink and drop its claim on every pending record.
+ *
+ * May be called by the sink task itself, then it does not return.
+ *
+ * @param sink Sink index.
+ */
+static void log_sink_stop(uint8_t sink) {
+    log_sink_t *s = &logger.sinks[sink];
+    TaskHandle_t task = s->task;
+    uint8_t self = (task == xTaskGetCurrentTaskHandle());
+    uint8_t bit = 1u << sink;
+
+    taskENTER_CRITICAL();
+    logger.active &= ~bit;
+    taskEXIT_CRITICAL();
+
+    // The task may be reading a record in place, stop it before releasing
+    if (!self) {
+        vTaskDelete(task);
+    }
+    s->task = NULL;
+
+    // Records are short, but walk them outside one long critical section
+    uint32_t i = logger.head;
+    while (1) {
+        taskENTER_CRITICAL();
+        if ((int32_t)(i - logger.head) < 0) {
+            i = logger.head;
+        }
+        if (i == logger.tail) {
+            log_reclaim();
+            taskEXIT_CRITICAL();
+            break;
+        }
+        log_rec_t *rec = log_rec_at(i);
+        if (rec->state == LOG_REC_RESERVED) {
+            // A writer is still copying, it used the old mask; try again shortly
+            taskEXIT_CRITICAL();
+            vTaskDelay(1);
+            continue;
+        }
+        rec->pending &= ~bit;
+        i += (rec->state == LOG_REC_PAD) ? rec->size : LOG_REC_TOTAL(rec->size);
+        taskEXIT_CRITICAL();
+    }
+
+    if (self) {
+        vTaskDelete(NULL);
+    }
+}
+
+/**
+ * @brief Reserve space for a record and mark it for every running sink.
+ *
+ * @param size Payload size in bytes.
+ * @param level Message level, with SYS_LOG_ISR when called from an interrupt.
+ * @param sinks Sinks the message is meant for.
+ * @return log_rec_t* Reserved record, NULL if the arena is full or none of the sinks runs.
+ */
+static log_rec_t *log_reserve(uint16_t size, uint8_t level, uint8_t sinks) {
+    uint8_t isr = (level & SYS_LOG_ISR) != 0;
+    uint32_t total = LOG_REC_TOTAL(size);
+    log_rec_t *rec = NULL;
+
+    UBaseType_t saved = log_lock(isr);
+    uint32_t offset = logger.tail & LOG_ARENA_MASK;
+    uint32_t pad = (offset + total > LOG_ARENA_SIZE) ? LOG_ARENA_SIZE - offset : 0;
+
+    if ((sinks & logger.active) && logger.tail + pad + total - logger.head <= LOG_ARENA_SIZE) {
+        if (pad) {
+            // Records never wrap, fill the end of the arena
+            log_rec_t *filler = log_rec_at(logger.tail);
+            filler->size = pad;
+            filler->pending = logger.active;
+            filler->state = LOG_REC_PAD;
+            logger.tail += pad;
+        }
+        rec = log_rec_at(logger.tail);
+        rec->size = size;
+        // Every running sink claims the record so the head never passes a reader
+        rec->pending = logger.active;
+        rec->sinks = sinks;
+        rec->state = LOG_REC_RESERVED;
+        rec->level = level & ~SYS_LOG_ISR;
+        logger.tail += total;
+    }
+    log_unlock(isr, saved);
+    return rec;
+}
+
+/**
+ * @brief Publish a reserved record and wake the sinks.
+ *
+ * @param rec Record returned by log_reserve().
+ * @param isr Set when called from an interrupt.
+ */
+static void log_commit(log_rec_t *rec, uint8_t isr) {
+    uint8_t pending = rec->pending;
+    BaseType_t woken = pdFALSE;
+
+    atomic_thread_fence(memory_order_release);
+    rec->state = LOG_REC_READY;
+
+    for (uint8_t i = 0; i < SYS_LOG_SINK_COUNT; i++) {
+        TaskHandle_t task = logger.sinks[i].task;
+        if ((pending & (1u << i)) && task != NULL) {
+            if (isr) vTaskNotifyGiveFromISR(task, &woken);
+            else xTaskNotifyGive(task);
+        }
+    }
+    if (isr) {
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/**
+ * @brief Copy a payload into a reserved record and publish it.
+ */
+static void log_publish(log_rec_t *rec, const void *data, uint16_t size, uint8_t isr) {
+    uint8_t *payload = (uint8_t*)(rec + 1);
+    memcpy(payload, data, size);
+    payload[size] = '\0';
+    log_commit(rec, isr);
+}
+
+/**
+ * @brief Count a message lost because the arena was full.
+ *
+ * @param level Level of the message.
+ * @param sinks Sinks the message was meant for.
+ * @param isr Set when called from an interrupt.
+ */
+static void log_drop(uint8_t level, uint8_t sinks, uint8_t isr) {
+    UBaseType_t saved = log_lock(isr);
+    logger.drops.total++;
+    logger.unreported++;
+    if (level <= SYS_LOG_VERBOSE) {
+        logger.drops.level[level]++;
+    }
+    for (uint8_t i = 0; i < SYS_LOG_SINK_COUNT; i++) {
+        if (sinks & logger.active & (1u << i)) {
+            logger.drops.sink[i]++;
+        }
+    }
+    log_unlock(isr, saved);
+}
+
+/**
+ * @brief Emit a "N messages dropped" record if drops happened since the last one.
+ *
+ * Rate limited to one record per LOG_DROP_REPORT_MS, task context only.
+ */
+static void log_report_drops(void) {
+    uint32_t now = HAL_GetTick();
+    uint32_t n;
+
+    // Claim the pending count so concurrent callers do not report it twice
+    taskENTER_CRITICAL();
+    n = logger.unreported;
+    if (n == 0 || now - logger.last_report < LOG_DROP_REPORT_MS) {
+        taskEXIT_CRITICAL();
+        return;
+    }
+    logger.unreported = 0;
+    logger.last_report = now;
+    taskEXIT_CRITICAL();
+
+#if SYS_LOG_BINARY
+    sys_log_bin_t msg = { .magic = SYS_LOG_BIN_MAGIC, .level = SYS_LOG_WARN, .nwords = 1,
+                          .timestamp = sys_log_timestamp(), .tag = TAG_SYS, .format = "%u messages dropped",
+                          .args = { n } };
+    uint16_t size = SYS_LOG_BIN_SIZE(&msg);
+#else
+    char msg[MAX_LOG_MESSAGE_SIZE];
+    uint16_t size = snprintf(msg, sizeof(msg), LOG_FORMAT("W", "%u messages dropped"),
+                             sys_log_timestamp(), TAG_SYS, (unsigned)n);
+#endif
+
+    log_rec_t *rec = log_reserve(size, SYS_LOG_WARN, 0xFF);
+    if (rec == NULL) {
+        taskENTER_CRITICAL();
+        logger.unreported += n;
+        taskEXIT_CRITICAL();
+        return;
+    }
+    log_publish(rec, &msg, size, 0);
+}
+
+/**
+ * @brief Copy a message into the arena once for all sinks.
+ *
+ * In blocking mode waits for the slowest sink to free space, as the
+ * per-sink queues did. In non-blocking mode and from interrupts a message
+ * that does not fit is dropped and counted.
+ *
+ * @param data Payload.
+ * @param size Payload size in bytes.
+ * @param level Message level, with SYS_LOG_ISR when called from an interrupt.
+ * @param sinks Sinks the message is meant for, from sys_log_sinks().
+ */
+static void log_dispatch(const void *data, uint16_t size, uint8_t level, uint8_t sinks) {
+    uint8_t isr = (level & SYS_LOG_ISR) != 0;
+    log_rec_t *rec;
+
+    if (!isr) {
+        log_report_drops();
+    }
+
+    while ((rec = log_reserve(size, level, sinks)) == NULL) {
+        if (!(logger.active & sinks)) return;
+        if (isr || logger.settings.non_blocking) {
+            log_drop(level & ~SYS_LOG_ISR, sinks, isr);
+            return;
+        }
+        vTaskDelay(1);
+    }
+    log_publish(rec, data, size, isr);
+}
+
+/**
+ * @brief Mark the sink's current record as consumed and move on.
+ *
+ * @param sink Sink index.
+ */
+static void log_sink_release(uint8_t sink) {
+    log_sink_t *s = &logger.sinks[sink];
+    log_rec_t *rec = log_rec_at(s->cursor);
+
+    s->cursor += (rec->state == LOG_REC_PAD) ? rec->size : LOG_REC_TOTAL(rec->size);
+    taskENTER_CRITICAL();
+    rec->pending &= ~(1u << sink);
+    log_reclaim();
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Next readable record for a sink, skipping padding.
+ *
+ * @param sink Sink index.
+ * @return const log_rec_t* Record, NULL if the sink is up to date.
+ */
+static const log_rec_t *log_sink_peek(uint8_t sink) {
+    log_sink_t *s = &logger.sinks[sink];
+
+    while (s->cursor != logger.tail) {
+        log_rec_t *rec = log_rec_at(s->cursor);
+        if (rec->state == LOG_REC_RESERVED) return NULL;
+        atomic_thread_fence(memory_order_acquire);
+        if (rec->state == LOG_REC_READY && (rec->sinks & (1u << sink))) return rec;
+        // Padding and records filtered out for this sink are just released
+        log_sink_release(sink);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Block until the sink has a record to process.
+ *
+ * @param sink Sink index.
+ * @param timeout Ticks to wait, portMAX_DELAY to wait forever.
+ * @return const log_rec_t* Record to process, release it with log_sink_release(); NULL on timeout.
+ */
+static const log_rec_t *log_sink_wait(uint8_t sink, TickType_t timeout) {
+    const log_rec_t *rec;
+    TickType_t start = xTaskGetTickCount();
+
+    while ((rec = log_sink_peek(sink)) == NULL) {
+        // Wake up now and then to announce drops even if nobody logs
+        TickType_t wait = pdMS_TO_TICKS(LOG_DROP_REPORT_MS);
+        if (timeout != portMAX_DELAY) {
+            TickType_t waited = xTaskGetTickCount() - start;
+            if (waited >= timeout) return NULL;
+            if (timeout - waited < wait) wait = timeout - waited;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+#if SYS_LOG_TIMESTAMP_US
+        log_tick64(); // Catch HAL tick wraps even if nobody logs for 49 days
+#endif
+        log_report_drops();
+    }
+    return rec;
+}
+
 /**
  * @brief Initialize the logging system.
  *
@@ -91,25 +487,43 @@ void SYS_LOG_Init(sys_log_settings_t *settings) {
     }
 
     logger.settings = *settings;
+    logger.head = logger.tail = 0;
+    logger.default_level = LOG_DEFAULT_LEVEL;
+    log_clock_init();
+    for (uint8_t i = 0; i < SYS_LOG_SINK_COUNT; i++) {
+        logger.sink_level[i] = SYS_LOG_VERBOSE;
+    }
+    logger.initialized = true;
 
     if (logger.settings.log_swv) {
-        LOG_CREATE_SWV();
+        log_sink_start(SYS_LOG_SINK_SWV);
     }
 
     if (logger.settings.log_udp) {
-        LOG_CREATE_UDP();
+        log_sink_start(SYS_LOG_SINK_UDP);
     }
 
     if (logger.settings.log_emmc) {
-        LOG_CREATE_MMC();
+        log_sink_start(SYS_LOG_SINK_MMC);
     }
 
-    if (!udpQueue || !mmcQueue || !swvQueue) {
-        printf("Failed to create log queues\n");
-        return;
+    if (logger.settings.log_flash) {
+        log_sink_start(SYS_LOG_SINK_FLASH);
     }
+}
 
-    logger.initialized = true;
+/**
+ * @brief Start or stop a sink to match its setting.
+ *
+ * @param sink Sink index.
+ * @param enable Requested state.
+ */
+static void log_sink_update(uint8_t sink, uint8_t enable) {
+    if (enable && logger.sinks[sink].task == NULL) {
+        log_sink_start(sink);
+    } else if (!enable && logger.sinks[sink].task != NULL) {
+        log_sink_stop(sink);
+    }
 }
 
 /**
@@ -120,52 +534,247 @@ void SYS_LOG_Init(sys_log_settings_t *settings) {
 void SYS_LOG_UpdateMethods(sys_log_settings_t *newSettings) {
     logger.settings = *newSettings;
 
-    if (logger.settings.log_swv && LogSWV_Handle == NULL) {
-        LOG_CREATE_SWV();
-    } else if (!logger.settings.log_swv && LogSWV_Handle != NULL) {
-        LOG_DELETE_SWV();
+    log_sink_update(SYS_LOG_SINK_SWV, logger.settings.log_swv);
+    log_sink_update(SYS_LOG_SINK_MMC, logger.settings.log_emmc);
+    log_sink_update(SYS_LOG_SINK_UDP, logger.settings.log_udp);
+    log_sink_update(SYS_LOG_SINK_FLASH, logger.settings.log_flash);
+}
+
+/**
+ * @brief Read the drop counters.
+ *
+ * @param drops Receives a snapshot of the counters.
+ */
+void SYS_LOG_GetDrops(sys_log_drops_t *drops) {
+    taskENTER_CRITICAL();
+    *drops = logger.drops;
+    taskEXIT_CRITICAL();
+}
+
+static inline uint32_t log_tag_hash(const char *tag) {
+    // Fibonacci hashing of the address, string literals are at least byte aligned
+    return ((uint32_t)(uintptr_t)tag * 2654435761u) >> (32 - LOG_TAG_BITS);
+}
+
+/**
+ * @brief Find the slot of a tag, or the free slot where it would go.
+ *
+ * @param tag Tag string.
+ * @return log_tag_level_t* Slot, NULL if the tag is absent and the table is full.
+ */
+static log_tag_level_t *log_tag_slot(const char *tag) {
+    uint32_t h = log_tag_hash(tag);
+    for (uint32_t n = 0; n < LOG_TAG_SLOTS; n++) {
+        log_tag_level_t *e = &logger.tags[(h + n) & (LOG_TAG_SLOTS - 1)];
+        if (e->tag == tag || e->tag == NULL) return e;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Set the runtime level of a tag.
+ *
+ * Tags are matched by address, use the same string constant in the call
+ * and in the log macros.
+ *
+ * @param tag Tag string, NULL to set the level of every tag without its own.
+ * @param level Highest level let through.
+ * @return uint8_t 1 on success, 0 if the tag table is full.
+ */
+uint8_t SYS_LOG_SetLevel(const char *tag, sys_log_level_t level) {
+    uint8_t ok = 1;
+
+    taskENTER_CRITICAL();
+    if (tag == NULL) {
+        logger.default_level = level;
+    } else {
+        log_tag_level_t *e = log_tag_slot(tag);
+        if (e == NULL) {
+            ok = 0;
+        } else {
+            // Readers do not lock: the level must be in place before the tag shows up
+            e->level = level;
+            atomic_thread_fence(memory_order_release);
+            e->tag = tag;
+        }
+    }
+    taskEXIT_CRITICAL();
+    return ok;
+}
+
+/**
+ * @brief Set the highest level a sink takes, whatever the tag.
+ *
+ * Sink levels and the default tag level are reset by SYS_LOG_Init().
+ *
+ * @param sink Sink to configure.
+ * @param level Highest level written to the sink.
+ */
+void SYS_LOG_SetSinkLevel(sys_log_sink_t sink, sys_log_level_t level) {
+    if (sink < SYS_LOG_SINK_COUNT) {
+        logger.sink_level[sink] = level;
+    }
+}
+
+/**
+ * @brief Sinks that take a message, checked by the log macros before formatting.
+ *
+ * @param level Message level, may carry SYS_LOG_ISR.
+ * @param tag Message tag.
+ * @return uint8_t Mask of running sinks (bit n is sys_log_sink_t n), 0 to skip the message.
+ */
+uint8_t sys_log_sinks(sys_log_level_t level, const char *tag) {
+    if (!logger.initialized) {
+        return 0;
+    }
+    level &= ~SYS_LOG_ISR;
+
+    uint8_t limit = logger.default_level;
+    log_tag_level_t *e = log_tag_slot(tag);
+    if (e != NULL && e->tag == tag) {
+        limit = e->level;
+    }
+    if (level > limit) {
+        return 0;
     }
 
-    if (logger.settings.log_emmc && LogMMC_Handle == NULL) {
-        LOG_CREATE_MMC();
-    } else if (!logger.settings.log_emmc && LogMMC_Handle != NULL) {
-        LOG_DELETE_MMC();
+    uint8_t sinks = 0;
+    for (uint8_t i = 0; i < SYS_LOG_SINK_COUNT; i++) {
+        if (level <= logger.sink_level[i]) sinks |= 1u << i;
     }
+    return sinks & logger.active;
+}
+
+#if SYS_LOG_TIMESTAMP_US
+
+/**
+ * @brief HAL tick extended to 64 bits.
+ *
+ * Counts the wraps of the 32-bit tick (every 49.7 days), so it must run at
+ * least once per wrap: the sink tasks call it each time they wake up. The
+ * FROM_ISR critical section only masks interrupts, so tasks may use it too.
+ *
+ * @return Milliseconds since boot.
+ */
+static uint64_t log_tick64(void) {
+    static uint32_t last, high;
 
-    if (logger.settings.log_udp && LogUDP_Handle == NULL) {
-        LOG_CREATE_UDP();
-    } else if (!logger.settings.log_udp && LogUDP_Handle != NULL) {
-        LOG_DELETE_UDP();
+    UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+    uint32_t tick = HAL_GetTick();
+    if (tick < last) high++;
+    last = tick;
+    uint64_t now = ((uint64_t)high << 32) | tick;
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+    return now;
+}
+
+#endif
+
+#if SYS_LOG_TIMESTAMP_US && defined(DWT_CTRL_CYCCNTENA_Msk)
+
+/**
+ * @brief Anchor of the cycle counter to the HAL tick.
+ */
+static struct {
+    uint64_t tick0;                  /*!< HAL tick at the anchor */
+    uint32_t cycles0;                /*!< CYCCNT at the anchor */
+    uint32_t per_ms;                 /*!< Core cycles per millisecond */
+    uint32_t per_us;                 /*!< Core cycles per microsecond */
+    uint8_t running;                 /*!< CYCCNT counts */
+} log_clock;
+
+/**
+ * @brief Start the DWT cycle counter and anchor it to the HAL tick.
+ */
+static void log_clock_init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    log_clock.per_ms = SystemCoreClock / 1000u;
+    log_clock.per_us = SystemCoreClock / 1000000u;
+    log_clock.tick0 = log_tick64();
+    log_clock.cycles0 = DWT->CYCCNT;
+    // Not every core implements the counter
+    log_clock.running = log_clock.per_us && !(DWT->CTRL & DWT_CTRL_NOCYCCNT_Msk) && (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk);
+}
+
+/**
+ * @brief Get the current timestamp for logging.
+ *
+ * The HAL tick tells roughly how many cycles have passed since the anchor;
+ * CYCCNT gives the exact low 32 bits. The number of counter wraps is the
+ * one that brings the two within half a wrap (25 s at 84 MHz), so no
+ * periodic call is needed to catch wraps and ISRs need no lock.
+ *
+ * @return Current timestamp in microseconds.
+ */
+sys_log_time_t sys_log_timestamp(void) {
+    if (!log_clock.running) {
+        return log_tick64() * 1000u;
     }
+
+    uint32_t cycles = DWT->CYCCNT;
+    uint64_t tick = log_tick64();
+    uint64_t estimate = log_clock.cycles0 + (tick - log_clock.tick0) * log_clock.per_ms;
+    int64_t error = (int64_t)(estimate - cycles);
+    uint64_t wraps = (uint64_t)((error + 0x80000000LL) >> 32);
+
+    return ((wraps << 32) | cycles) / log_clock.per_us;
+}
+
+#else
+
+static void log_clock_init(void) {
 }
 
 /**
  * @brief Get the current timestamp for logging.
  *
- * @return Current timestamp in milliseconds.
+ * @return Current timestamp in milliseconds, in microseconds with SYS_LOG_TIMESTAMP_US.
  */
-uint32_t sys_log_timestamp(void) {
+sys_log_time_t sys_log_timestamp(void) {
+#if SYS_LOG_TIMESTAMP_US
+    return log_tick64() * 1000u;
+#else
     return HAL_GetTick();
+#endif
 }
 
+#endif /* SYS_LOG_TIMESTAMP_US */
+
+#if SYS_LOG_BINARY
+_Static_assert(SYS_LOG_BIN_TEXT_WORDS <= UINT8_MAX, "MAX_LOG_MESSAGE_SIZE too long for a binary record");
+#endif
+
 /**
  * @brief Write a log message.
  *
- * @param level Log level.
+ * @param level Log level, OR-ed with SYS_LOG_ISR when called from an interrupt.
  * @param tag Log tag.
  * @param format Message format string.
  * @param ... Additional arguments for the format string.
  */
 void sys_log_write(sys_log_level_t level, const char *tag, const char *format, ...) {
-    if (!logger.initialized) {
+    uint8_t sinks = sys_log_sinks(level, tag);
+    if (!sinks) {
         return;
     }
 
+#if SYS_LOG_BINARY
+    // Preformatted text (e.g. from modules calling sys_log_write directly) is
+    // formatted straight into the argument words of a record with an empty format
+    union {
+        sys_log_bin_t rec;
+        uint8_t raw[offsetof(sys_log_bin_t, args) + SYS_LOG_BIN_TEXT_WORDS * sizeof(uint32_t)];
+    } bin;
+    char *logMessage = (char*)bin.raw + offsetof(sys_log_bin_t, args);
+#else
     char logMessage[MAX_LOG_MESSAGE_SIZE];
+#endif
     va_list list;
     va_start(list, format);
 
-    int length = vsprintf(logMessage, format, list);
+    int length = vsnprintf(logMessage, MAX_LOG_MESSAGE_SIZE, format, list);
     va_end(list);
 
     if (length < 0 || length >= MAX_LOG_MESSAGE_SIZE) {
@@ -173,17 +782,284 @@ void sys_log_write(sys_log_level_t level, const char *tag, const char *format, .
         logMessage[length] = '\0';
     }
 
-    if (logger.settings.log_swv) {
-        xQueueSend(swvQueue, logMessage, portMAX_DELAY);
+#if SYS_LOG_BINARY
+    while (length > 0 && logMessage[length - 1] == '\n') {
+        logMessage[--length] = '\0';
     }
+    size_t words = (length + sizeof(uint32_t)) / sizeof(uint32_t);
+    memset(logMessage + length, 0, words * sizeof(uint32_t) - length);
+    bin.rec.magic = SYS_LOG_BIN_MAGIC;
+    bin.rec.level = level & ~SYS_LOG_ISR;
+    bin.rec.nwords = words;
+    bin.rec.timestamp = sys_log_timestamp();
+    bin.rec.tag = tag;
+    bin.rec.format = "";
+    log_dispatch(&bin.rec, SYS_LOG_BIN_SIZE(&bin.rec), level, sinks);
+#else
+    log_dispatch(logMessage, length, level, sinks);
+#endif
+}
 
-    if (logger.settings.log_udp) {
-        xQueueSend(udpQueue, logMessage, portMAX_DELAY);
+#if SYS_LOG_BINARY
+
+/** Level letters indexed by sys_log_level_t */
+static const char log_level_letter[] = "NEWIDV";
+
+/**
+ * @brief Record a binary log message, used by SYS_LOG_LEVEL when SYS_LOG_BINARY is set.
+ *
+ * Copies the arguments into a sys_log_bin_t without formatting them.
+ *
+ * @param level Log level, OR-ed with SYS_LOG_ISR when called from an interrupt.
+ * @param tag Log tag.
+ * @param format Message format string.
+ * @param sig Argument signature built by SYS_LOG_SIG.
+ * @param ... Arguments for the format string.
+ */
+void sys_log_write_bin(sys_log_level_t level, const char *tag, const char *format, uint32_t sig, ...) {
+    uint8_t sinks = sys_log_sinks(level, tag);
+    if (!sinks) {
+        return;
     }
 
-    if (logger.settings.log_emmc) {
-        xQueueSend(mmcQueue, logMessage, portMAX_DELAY);
+    sys_log_bin_t rec;
+    rec.magic = SYS_LOG_BIN_MAGIC;
+    rec.level = level & ~SYS_LOG_ISR;
+    rec.timestamp = sys_log_timestamp();
+    rec.tag = tag;
+    rec.format = format;
+
+    // The signature gives the class of every argument, the format is not parsed here
+    uint32_t nargs = sig & 0x0Fu;
+    uint32_t w = 0;
+    va_list list;
+    va_start(list, sig);
+    for (uint32_t i = 0; i < nargs; i++) {
+        uint32_t cls = (sig >> (4 + 2 * i)) & 0x03u;
+        if (cls == SYS_LOG_ARG_WORD) {
+            rec.args[w++] = va_arg(list, uint32_t);
+        } else {
+            uint64_t v;
+            if (cls == SYS_LOG_ARG_DOUBLE) {
+                double d = va_arg(list, double);
+                memcpy(&v, &d, sizeof(v));
+            } else {
+                v = va_arg(list, uint64_t);
+            }
+            rec.args[w++] = (uint32_t)v;
+            rec.args[w++] = (uint32_t)(v >> 32);
+        }
     }
+    va_end(list);
+    rec.nwords = w;
+
+    log_dispatch(&rec, SYS_LOG_BIN_SIZE(&rec), level, sinks);
+}
+
+/** Advance the output length by an snprintf result, clamped to the buffer. */
+static size_t log_advance(size_t size, size_t len, int n) {
+    if (n < 0) return len;
+    return (len + n >= size) ? size - 1 : len + n;
+}
+
+/**
+ * @brief Format a binary record as a text line.
+ *
+ * Every conversion of the format is rebuilt with a normalized length
+ * modifier and printed on its own, taking its argument words from the record.
+ *
+ * @param rec Record to format.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return Length of the text, truncated to size - 1.
+ */
+size_t sys_log_render(const sys_log_bin_t *rec, char *buf, size_t size) {
+    if (size < 2) {
+        if (size) buf[0] = '\0';
+        return 0;
+    }
+
+    uint8_t level = (rec->level < sizeof(log_level_letter) - 1) ? rec->level : SYS_LOG_INFO;
+    size_t len = log_advance(size, 0, snprintf(buf, size, "%c (" SYS_LOG_TIME_FMT ") %s: ", log_level_letter[level],
+                                               (sys_log_time_t)rec->timestamp, rec->tag));
+
+    // Preformatted text from sys_log_write
+    if (rec->format[0] == '\0' && rec->nwords) {
+        len = log_advance(size, len, snprintf(buf + len, size - len, "%s", (const char*)rec->args));
+    }
+
+    const char *f = rec->format;
+    uint32_t w = 0;
+    while (*f && len < size - 1) {
+        if (*f != '%') {
+            buf[len++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            buf[len++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Flags, width and precision are copied, '*' takes an argument word
+        char spec[16];
+        size_t sl = 0;
+        int star[2] = { 0, 0 };
+        uint8_t stars = 0;
+        spec[sl++] = *f++;
+        while (*f && strchr("-+ #0123456789.*", *f) && sl < sizeof(spec) - 4) {
+            if (*f == '*') {
+                if (stars == 2 || w >= rec->nwords) break;
+                star[stars++] = (int)rec->args[w++];
+            }
+            spec[sl++] = *f++;
+        }
+
+        // Length modifier decides the argument size, then is replaced by "ll" or nothing
+        uint8_t words = 1;
+        uint8_t half = 0;
+        while (*f && strchr("hljztL", *f)) {
+            if (*f == 'h') half++;
+            else if (*f == 'j' || (*f == 'l' && f[1] == 'l')) words = 2;
+            else if (*f == 'l' || *f == 'z' || *f == 't') words = (sizeof(long) > 4) ? 2 : words;
+            f += (*f == 'l' && f[1] == 'l') ? 2 : 1;
+        }
+        char conv = *f;
+        if (conv == '\0') break;
+        f++;
+
+        if (strchr("fFeEgGaA", conv)) words = 2;
+        else if (conv == 's' || conv == 'p') words = sizeof(void*) / sizeof(uint32_t);
+        else if (!strchr("diouxXcn", conv)) continue;
+
+        if (w + words > rec->nwords) {
+            len = log_advance(size, len, snprintf(buf + len, size - len, "<?>"));
+            break;
+        }
+        uint64_t v = rec->args[w];
+        if (words == 2) v |= (uint64_t)rec->args[w + 1] << 32;
+        w += words;
+
+        if (words == 2 && strchr("diouxX", conv)) {
+            spec[sl++] = 'l';
+            spec[sl++] = 'l';
+        }
+        spec[sl++] = conv;
+        spec[sl] = '\0';
+
+        char *out = buf + len;
+        size_t room = size - len;
+        int n = 0;
+#define LOG_EMIT(val) ((stars == 0) ? snprintf(out, room, spec, val) :                 \
+                       (stars == 1) ? snprintf(out, room, spec, star[0], val) :        \
+                                      snprintf(out, room, spec, star[0], star[1], val))
+        switch (conv) {
+        case 'd':
+        case 'i':
+            if (words == 2) n = LOG_EMIT((long long)v);
+            else n = LOG_EMIT((half == 2) ? (signed char)v : (half == 1) ? (short)v : (int)(int32_t)v);
+            break;
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            if (words == 2) n = LOG_EMIT((unsigned long long)v);
+            else n = LOG_EMIT((half == 2) ? (uint8_t)v : (half == 1) ? (uint16_t)v : (unsigned)v);
+            break;
+        case 'c':
+            n = LOG_EMIT((int)v);
+            break;
+        case 's':
+            n = LOG_EMIT(v ? (const char*)(uintptr_t)v : "(null)");
+            break;
+        case 'p':
+            n = LOG_EMIT((void*)(uintptr_t)v);
+            break;
+        case 'n':
+            break;
+        default: {
+            double d;
+            memcpy(&d, &v, sizeof(d));
+            n = LOG_EMIT(d);
+            break;
+        }
+        }
+#undef LOG_EMIT
+        len = log_advance(size, len, n);
+    }
+
+    // Always end with a newline, even when truncated
+    if (len >= size - 1) len = size - 2;
+    buf[len++] = '\n';
+    buf[len] = '\0';
+    return len;
+}
+
+#endif /* SYS_LOG_BINARY */
+
+/**
+ * @brief Check that a stimulus port will be drained: debugger attached, ITM and the port enabled.
+ *
+ * @param port Stimulus port.
+ * @return uint8_t 1 if writes to the port reach the SWO pin.
+ */
+static inline uint8_t log_itm_ready(uint8_t port) {
+    return (CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk)
+        && (ITM->TCR & ITM_TCR_ITMENA_Msk)
+        && (ITM->TER & (1u << port));
+}
+
+/**
+ * @brief Wait a bounded time for room in the stimulus port FIFO.
+ *
+ * @param port Stimulus port.
+ * @return uint8_t 1 if the port accepts a write, 0 after LOG_ITM_SPIN polls.
+ */
+static inline uint8_t log_itm_wait(uint8_t port) {
+    for (uint32_t n = LOG_ITM_SPIN; n; n--) {
+        if (ITM->PORT[port].u32 != 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Send bytes to an ITM stimulus port, four per write.
+ *
+ * Word and halfword writes go out as one SWO packet each, low byte first,
+ * so the host sees the bytes in order. The rest of the message is dropped
+ * if the FIFO stays full for LOG_ITM_SPIN polls.
+ *
+ * @param port Stimulus port, 0..31.
+ * @param data Bytes to send.
+ * @param len Number of bytes.
+ * @return uint8_t 1 if everything was sent, 0 otherwise.
+ */
+static uint8_t log_itm_send(uint8_t port, const char *data, size_t len) {
+    if (!log_itm_ready(port)) {
+        return 0;
+    }
+
+    while (len >= 4) {
+        uint32_t word;
+        memcpy(&word, data, 4);
+        if (!log_itm_wait(port)) return 0;
+        ITM->PORT[port].u32 = word;
+        data += 4;
+        len -= 4;
+    }
+    if (len >= 2) {
+        uint16_t half;
+        memcpy(&half, data, 2);
+        if (!log_itm_wait(port)) return 0;
+        ITM->PORT[port].u16 = half;
+        data += 2;
+        len -= 2;
+    }
+    if (len) {
+        if (!log_itm_wait(port)) return 0;
+        ITM->PORT[port].u8 = (uint8_t)*data;
+    }
+    return 1;
 }
 
 /**
@@ -192,40 +1068,90 @@ void sys_log_write(sys_log_level_t level, const char *tag, const char *format, .
  * @param str Pointer to the null-terminated string to send.
  */
 void ITM_SendString(const char *str) {
-    while (*str) {
-        if (ITM->PORT[0].u32 == 1) {
-            ITM->PORT[0].u32 = *str++;
-        }
-    }
+    log_itm_send(0, str, strlen(str));
 }
 
 /**
  * @brief Thread for sending logs using SWV.
  *
+ * Each level goes to its own stimulus port, see LOG_ITM_PORT.
+ *
  * @param arg Unused parameter.
  */
 void LogTask_SWV(void *arg) {
-    char logMessage[MAX_LOG_MESSAGE_SIZE];
-
     while (1) {
-        if (xQueueReceive(swvQueue, logMessage, portMAX_DELAY) == pdPASS) {
-            ITM_SendString(logMessage);
-        }
+        const log_rec_t *rec = log_sink_wait(SYS_LOG_SINK_SWV, portMAX_DELAY);
+        uint8_t port = LOG_ITM_PORT(rec->level);
+#if SYS_LOG_BINARY
+        char logMessage[MAX_LOG_MESSAGE_SIZE];
+        size_t len = sys_log_render((const sys_log_bin_t*)(rec + 1), logMessage, sizeof(logMessage));
+        log_itm_send(port, logMessage, len);
+#else
+        log_itm_send(port, (const char*)(rec + 1), rec->size);
+#endif
+        log_sink_release(SYS_LOG_SINK_SWV);
+    }
+}
+
+/**
+ * @brief Datagram being assembled by the UDP sink.
+ */
+typedef struct {
+    int sock;                        /*!< lwIP socket */
+    struct sockaddr_in addr;         /*!< Multicast destination */
+    uint16_t fill;                   /*!< Bytes in the datagram, header included */
+    uint16_t count;                  /*!< Messages in the datagram */
+    uint32_t seq;                    /*!< Sequence number of the datagram */
+    TickType_t first;                /*!< Tick the first message was added */
+} log_udp_t;
+
+#if SYS_LOG_BINARY
+_Static_assert(LOG_UDP_DATAGRAM_SIZE >= sizeof(sys_log_udp_hdr_t) + offsetof(sys_log_bin_t, args) +
+               SYS_LOG_BIN_TEXT_WORDS * sizeof(uint32_t),
+               "LOG_UDP_DATAGRAM_SIZE must hold the header and the longest record");
+#else
+_Static_assert(LOG_UDP_DATAGRAM_SIZE >= sizeof(sys_log_udp_hdr_t) + MAX_LOG_MESSAGE_SIZE,
+               "LOG_UDP_DATAGRAM_SIZE must hold the header and the longest message");
+#endif
+
+static uint8_t logUdpBuffer[LOG_UDP_DATAGRAM_SIZE] __attribute__((aligned(4)));
+
+/**
+ * @brief Send the datagram if it holds any message and start the next one.
+ *
+ * @param u Sink state.
+ */
+static void log_udp_flush(log_udp_t *u) {
+    sys_log_udp_hdr_t *hdr = (sys_log_udp_hdr_t*)logUdpBuffer;
+
+    if (u->count) {
+        hdr->magic = SYS_LOG_UDP_MAGIC;
+        hdr->version = SYS_LOG_UDP_VERSION;
+        hdr->flags = SYS_LOG_BINARY ? SYS_LOG_UDP_BINARY : 0;
+        hdr->node_id = logger.settings.node_id;
+        hdr->count = u->count;
+        hdr->seq = u->seq++;
+        lwip_sendto(u->sock, logUdpBuffer, u->fill, 0, (struct sockaddr*)&u->addr, sizeof(u->addr));
     }
+    u->fill = sizeof(sys_log_udp_hdr_t);
+    u->count = 0;
 }
+
 /**
  * @brief Thread for sending logs using UDP.
  *
+ * Messages are packed into datagrams of up to LOG_UDP_DATAGRAM_SIZE bytes.
+ * A datagram is sent when the next message does not fit, LOG_UDP_FLUSH_MS
+ * after its first message, or right after an ERROR message.
+ *
  * @param arg Unused parameter.
  */
 void LogTask_UDP(void *arg) {
-    struct sockaddr_in udp_log;
-    int udp_sock;
-    char logMessage[MAX_LOG_MESSAGE_SIZE];
+    static log_udp_t udp;
 
     // Create UDP socket
-    if ((udp_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
-        vTaskDelete(NULL);
+    if ((udp.sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
+        log_sink_stop(SYS_LOG_SINK_UDP);
         return;
     }
 
@@ -233,92 +1159,309 @@ void LogTask_UDP(void *arg) {
     ip_addr_t ip_addr;
     IP_ADDR4(&ip_addr, 239, 255, 50, 50);
 
-    udp_log.sin_family = AF_INET;
-    udp_log.sin_port = htons(LOG_UDP_PORT);
-    udp_log.sin_addr.s_addr = ip_addr.addr;
+    udp.addr.sin_family = AF_INET;
+    udp.addr.sin_port = htons(LOG_UDP_PORT);
+    udp.addr.sin_addr.s_addr = ip_addr.addr;
+    udp.seq = 0;
+    udp.count = 0;
+    log_udp_flush(&udp);
 
     while (1) {
-        if (xQueueReceive(udpQueue, logMessage, portMAX_DELAY) == pdPASS) {
-            lwip_sendto(udp_sock, logMessage, strlen(logMessage), 0, (struct sockaddr*)&udp_log, sizeof(udp_log));
+        TickType_t timeout = portMAX_DELAY;
+        if (udp.count) {
+            TickType_t elapsed = xTaskGetTickCount() - udp.first;
+            timeout = (elapsed >= pdMS_TO_TICKS(LOG_UDP_FLUSH_MS)) ? 0 : pdMS_TO_TICKS(LOG_UDP_FLUSH_MS) - elapsed;
+        }
+
+        const log_rec_t *rec = log_sink_wait(SYS_LOG_SINK_UDP, timeout);
+        if (rec == NULL) {
+            log_udp_flush(&udp);
+            continue;
+        }
+
+        if (udp.fill + rec->size > LOG_UDP_DATAGRAM_SIZE) {
+            log_udp_flush(&udp);
+        }
+        if (udp.count == 0) {
+            udp.first = xTaskGetTickCount();
+        }
+        memcpy(logUdpBuffer + udp.fill, rec + 1, rec->size);
+        udp.fill += rec->size;
+        udp.count++;
+
+        uint8_t level = rec->level;
+        log_sink_release(SYS_LOG_SINK_UDP);
+        if (level == SYS_LOG_ERROR) {
+            log_udp_flush(&udp);
+        }
+    }
+}
+
+#define LOG_MMC_SECTOR 512u
+
+/**
+ * @brief Write-behind state of the eMMC sink.
+ *
+ * The buffer always starts on a sector boundary of the file: full sectors
+ * leave it on a flush, a partial last sector stays and is written again,
+ * whole, by the next flush.
+ */
+typedef struct {
+    FIL file;                        /*!< Current log file, kept open */
+    uint8_t open;                    /*!< file is valid */
+    uint8_t dirty;                   /*!< Buffer holds bytes not written yet */
+    uint8_t unsynced;                /*!< Written bytes not committed with f_sync */
+    uint32_t fill;                   /*!< Bytes in the buffer */
+    uint32_t base;                   /*!< File offset of the first buffered byte */
+    TickType_t dirty_since;          /*!< Tick of the oldest unwritten byte */
+    TickType_t last_sync;            /*!< Tick of the last f_sync */
+    TickType_t open_failed;          /*!< Tick of the last failed f_open */
+    uint32_t first_seq;              /*!< Sequence number of the oldest log file */
+    uint32_t next_seq;               /*!< Sequence number of the next log file */
+#if LOG_MMC_PREALLOCATE
+    uint8_t expanded;                /*!< file was preallocated and needs truncating */
+#endif
+} log_mmc_t;
+
+static uint8_t logMmcBuffer[LOG_MMC_BUFFER_SIZE] __attribute__((aligned(4)));
+
+/**
+ * @brief Write the buffer to the file and sync it if the interval is over.
+ *
+ * @param m Writer state.
+ * @param sync Force an f_sync.
+ * @return FRESULT FatFS operation result.
+ */
+static FRESULT log_mmc_flush(log_mmc_t *m, uint8_t sync) {
+    FRESULT res = FR_OK;
+    TickType_t now = xTaskGetTickCount();
+
+    if (m->dirty) {
+        UINT written;
+        if (f_tell(&m->file) != m->base) {
+            res = f_lseek(&m->file, m->base);
+        }
+        if (res == FR_OK) {
+            res = f_write(&m->file, logMmcBuffer, m->fill, &written);
+        }
+        if (res == FR_OK && written != m->fill) {
+            res = FR_DENIED;    // Volume full
+        }
+        m->unsynced = 1;
+
+        if (res != FR_OK) {
+            // Keep the data at the same offset so the file stays contiguous, retry later
+            m->dirty_since = now;
+        } else {
+            // Keep the partial sector, it is written again whole by the next flush
+            uint32_t whole = m->fill & ~(LOG_MMC_SECTOR - 1u);
+            memmove(logMmcBuffer, logMmcBuffer + whole, m->fill - whole);
+            m->fill -= whole;
+            m->base += whole;
+            m->dirty = 0;
+        }
+    }
+
+    if (m->unsynced && (sync || now - m->last_sync >= pdMS_TO_TICKS(logger.settings.sync_interval))) {
+        FRESULT sres = f_sync(&m->file);
+        if (res == FR_OK) res = sres;
+        m->unsynced = 0;
+        m->last_sync = now;
+    }
+    return res;
+}
+
+/**
+ * @brief Append a message to the buffer, writing it out each time it fills up.
+ *
+ * @param m Writer state.
+ * @param data Message bytes.
+ * @param size Message size in bytes.
+ */
+static void log_mmc_append(log_mmc_t *m, const uint8_t *data, uint32_t size) {
+    while (size) {
+        uint32_t chunk = LOG_MMC_BUFFER_SIZE - m->fill;
+        if (chunk > size) chunk = size;
+
+        memcpy(logMmcBuffer + m->fill, data, chunk);
+        if (!m->dirty) {
+            m->dirty = 1;
+            m->dirty_since = xTaskGetTickCount();
+        }
+        m->fill += chunk;
+        data += chunk;
+        size -= chunk;
+
+        while (m->fill == LOG_MMC_BUFFER_SIZE && log_mmc_flush(m, 0) != FR_OK) {
+            // No room for the rest: wait and retry, new messages stay in the arena meanwhile
+            ITM_SendString("MMC: Log write failed\n");
+            vTaskDelay(pdMS_TO_TICKS(LOG_MMC_FLUSH_MS));
         }
     }
 }
 
 /**
- * @brief Manage log files in a directory.
+ * @brief Ticks until buffered data must be written or synced.
+ *
+ * @param m Writer state.
+ * @return TickType_t Timeout for log_sink_wait() or until the next f_open attempt,
+ *         portMAX_DELAY if nothing is pending.
+ */
+static TickType_t log_mmc_timeout(const log_mmc_t *m) {
+    TickType_t now = xTaskGetTickCount();
+    TickType_t start, limit;
+
+    if (!m->open) {
+        start = m->open_failed;
+        limit = pdMS_TO_TICKS(LOG_MMC_RETRY_MS);
+    } else if (m->dirty) {
+        start = m->dirty_since;
+        limit = pdMS_TO_TICKS(LOG_MMC_FLUSH_MS);
+    } else if (m->unsynced) {
+        start = m->last_sync;
+        limit = pdMS_TO_TICKS(logger.settings.sync_interval);
+    } else {
+        return portMAX_DELAY;
+    }
+    return (now - start >= limit) ? 0 : limit - (now - start);
+}
+
+/**
+ * @brief Sequence number of a log file name.
+ *
+ * @param name File name without directory.
+ * @param seq Receives the sequence number.
+ * @return uint8_t 1 if the name is a log file name, 0 otherwise.
+ */
+static uint8_t log_mmc_parse(const char *name, uint32_t *seq) {
+    const size_t prefix = sizeof(LOG_MMC_FILE_PREFIX) - 1;
+    char *end;
+
+    if (strncmp(name, LOG_MMC_FILE_PREFIX, prefix) != 0 || name[prefix] < '0' || name[prefix] > '9') {
+        return 0;
+    }
+    *seq = strtoul(name + prefix, &end, 10);
+    return strcmp(end, LOG_MMC_FILE_EXT) == 0;
+}
+
+/**
+ * @brief Find the oldest and newest log file, once when the sink starts.
  *
- * @param new_name Pointer to store the valid filename.
+ * @param m Writer state.
  * @return FRESULT FatFS operation result.
  */
-FRESULT ManageLogFiles(char *new_name) {
-    FRESULT res;
+static FRESULT log_mmc_scan(log_mmc_t *m) {
     DIR dir;
     FILINFO fno;
-    char old_name[LOG_FILENAME_LEN];
-    uint16_t file_numbers[128] = { 0 }; // Assumes no more than 128 files
-    uint16_t file_count = 0;
+    uint8_t found = 0;
+    FRESULT res = f_opendir(&dir, LOG_MMC_DIR);
 
-    // Open directory
-    res = f_opendir(&dir, LOG_MMC_DIR);
+    m->first_seq = 0;
+    m->next_seq = 0;
     if (res != FR_OK) {
         return res;
     }
-
-    // Read all files matching the pattern
     while ((res = f_readdir(&dir, &fno)) == FR_OK && fno.fname[0] != 0) {
-        unsigned int num;
-        if (sscanf(fno.fname, LOG_MMC_FILE_FORMAT, &num) == 1) {
-            if (file_count < sizeof(file_numbers) / sizeof(file_numbers[0])) {
-                file_numbers[file_count++] = num;
-            }
+        char old_name[sizeof(LOG_MMC_DIR) + sizeof(fno.fname)], new_name[LOG_FILENAME_LEN];
+        uint32_t seq;
+        if (!log_mmc_parse(fno.fname, &seq)) continue;
+
+        // Files from the narrower naming scheme are renamed once so rotation can find them
+        snprintf(new_name, LOG_FILENAME_LEN, LOG_MMC_DIR LOG_MMC_FILE_FORMAT, (unsigned long)seq);
+        if (strcmp(fno.fname, new_name + sizeof(LOG_MMC_DIR) - 1) != 0) {
+            snprintf(old_name, sizeof(old_name), LOG_MMC_DIR "%s", fno.fname);
+            f_rename(old_name, new_name);
         }
+        if (!found || seq < m->first_seq) m->first_seq = seq;
+        if (!found || seq >= m->next_seq) m->next_seq = seq + 1;
+        found = 1;
     }
     f_closedir(&dir);
+    return res;
+}
 
-    if (res != FR_OK) {
-        return res;
-    }
+/**
+ * @brief Delete the oldest log file if the limit is reached and name the next one.
+ *
+ * Costs one f_unlink per rotation, whatever the number of files.
+ *
+ * @param m Writer state.
+ * @param path Receives the name of the new file.
+ */
+static void log_mmc_next_file(log_mmc_t *m, char *path) {
+    uint32_t max_files = logger.settings.max_files ? logger.settings.max_files : 1;
 
-    uint16_t i;
-    uint16_t deleted_files = 0;
-    // Delete oldest files if file count exceeds limit
-    if (file_count > logger.settings.max_files - 1) {
-        for (i = 0; i < file_count - logger.settings.max_files + 1; i++) {
-            snprintf(old_name, LOG_FILENAME_LEN, LOG_MMC_DIR LOG_MMC_FILE_FORMAT, file_numbers[i]);
-            f_unlink(old_name);
-            deleted_files++;
-        }
+    // Files may be missing after a manual cleanup, f_unlink then just fails
+    while (m->next_seq - m->first_seq >= max_files) {
+        snprintf(path, LOG_FILENAME_LEN, LOG_MMC_DIR LOG_MMC_FILE_FORMAT, (unsigned long)m->first_seq++);
+        f_unlink(path);
+    }
+    snprintf(path, LOG_FILENAME_LEN, LOG_MMC_DIR LOG_MMC_FILE_FORMAT, (unsigned long)m->next_seq++);
+}
 
-        file_count = logger.settings.max_files - 1; // Update count after deletion
+/**
+ * @brief Open a new log file.
+ *
+ * @param m Writer state.
+ * @param path Name of the file.
+ * @return uint8_t 1 if the file is open, 0 to try again after LOG_MMC_RETRY_MS.
+ */
+static uint8_t log_mmc_open(log_mmc_t *m, const char *path) {
+    if (f_open(&m->file, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        ITM_SendString("MMC: Log file open failed\n");
+        m->open_failed = xTaskGetTickCount();
+        return 0;
     }
+    m->open = 1;
+    m->last_sync = xTaskGetTickCount();
+#if LOG_MMC_PREALLOCATE
+    // Contiguous clusters spare FAT lookups while writing; a fragmented volume just skips this
+    m->expanded = (f_expand(&m->file, logger.settings.file_size, 1) == FR_OK);
+#endif
+    return 1;
+}
 
-    // Rename files to maintain sequential numbering
-    for (i = 0; i < file_count; i++) {
-        snprintf(old_name, LOG_FILENAME_LEN, LOG_MMC_DIR LOG_MMC_FILE_FORMAT, file_numbers[i + deleted_files]);
-        snprintf(new_name, LOG_FILENAME_LEN, LOG_MMC_DIR LOG_MMC_FILE_FORMAT, i);
-        if (strcmp(old_name, new_name) != 0) {
-            res = f_rename(old_name, new_name);
-            if (res != FR_OK) {
-                return res;
-            }
-        }
+/**
+ * @brief Close the current log file and open a new one.
+ *
+ * @param m Writer state.
+ * @param path Receives the name of the new file.
+ */
+static void log_mmc_rotate(log_mmc_t *m, char *path) {
+    if (m->open) {
+        log_mmc_flush(m, 1);
+#if LOG_MMC_PREALLOCATE
+        // The flush leaves the file pointer at the end of the data
+        if (m->expanded) f_truncate(&m->file);
+#endif
+        f_close(&m->file);
+        m->open = 0;
     }
+    m->fill = 0;
+    m->base = 0;
+    m->dirty = 0;
+    m->unsynced = 0;
 
-    // Create new file with the next available number
-    snprintf(new_name, LOG_FILENAME_LEN, LOG_MMC_DIR LOG_MMC_FILE_FORMAT, file_count);
-    return res;
+    log_mmc_next_file(m, path);
+    log_mmc_open(m, path);
 }
 
 /**
  * @brief Thread for storing logs in MMC Chip.
  *
+ * Messages are collected in a sector-aligned buffer and written when it
+ * fills, LOG_MMC_FLUSH_MS after the oldest buffered message, or right away
+ * for an ERROR message. The file stays open and is synced every
+ * sync_interval ms. Buffered messages are lost if the sink is switched off.
+ * While no file can be opened, messages wait in the log arena and f_open is
+ * tried again every LOG_MMC_RETRY_MS. A failed write is retried at the same
+ * file offset every LOG_MMC_FLUSH_MS, so the file never has holes.
+ *
  * @param arg Unused parameter.
  */
 void LogTask_eMMC(void *arg) {
-    FIL logFile;
+    static log_mmc_t mmc;
     char filePath[LOG_FILENAME_LEN];
-    char logMessage[MAX_LOG_MESSAGE_SIZE];
-    uint32_t currentFileSize = 0;        // Track current file size
 
     // Check if LOG_DIR exists & try to create it
     DIR dir;
@@ -327,41 +1470,363 @@ void LogTask_eMMC(void *arg) {
         res = f_mkdir(LOG_MMC_DIR);
         if (res != FR_OK) {
             ITM_SendString("MMC: Create log dir error\n");
-            vTaskDelete(NULL);
+            log_sink_stop(SYS_LOG_SINK_MMC);
         }
     } else if (res != FR_OK) {
         ITM_SendString("MMC: Log dir open error\n");
-        vTaskDelete(NULL);
+        log_sink_stop(SYS_LOG_SINK_MMC);
     } else {
         f_closedir(&dir); // All OK
     }
 
-    // Initialize file management
-    if (ManageLogFiles(filePath) != FR_OK) {
-        ITM_SendString("MMC: Log manager failed\n");
+    // A previous run of the task may have been deleted with the file open
+    if (mmc.open) {
+        f_close(&mmc.file);
+        mmc.open = 0;
     }
+    if (log_mmc_scan(&mmc) != FR_OK) {
+        ITM_SendString("MMC: Log dir scan failed\n");
+    }
+    log_mmc_rotate(&mmc, filePath);
 
-    // Open file, check & save initial size (must be 0)
-    res = f_open(&logFile, filePath, FA_CREATE_NEW | FA_WRITE);
-    if (res != FR_OK) {
-        ITM_SendString("MMC: Log file open failed\n");
-    } else {
-        currentFileSize = f_size(&logFile);
+    while (1) {
+        if (!mmc.open) {
+            // Card late or gone: leave the records in the arena and try again
+            vTaskDelay(log_mmc_timeout(&mmc));
+            log_mmc_open(&mmc, filePath);
+            continue;
+        }
+
+        const log_rec_t *rec = log_sink_wait(SYS_LOG_SINK_MMC, log_mmc_timeout(&mmc));
+        if (rec == NULL) {
+            // Flush or sync deadline
+            if (log_mmc_flush(&mmc, 0) != FR_OK) ITM_SendString("MMC: Log write failed\n");
+            continue;
+        }
+
+        uint8_t level = rec->level;
+        log_mmc_append(&mmc, (const uint8_t*)(rec + 1), rec->size);
+        log_sink_release(SYS_LOG_SINK_MMC);
+
+        if (level == SYS_LOG_ERROR && log_mmc_flush(&mmc, 1) != FR_OK) {
+            ITM_SendString("MMC: Log write failed\n");
+        }
+        if (mmc.base + mmc.fill >= logger.settings.file_size) {
+            log_mmc_rotate(&mmc, filePath);
+        }
+    }
+}
+
+#define LOG_FLASH_PAYLOAD (W25Qx_PAGE_SIZE - sizeof(sys_log_flash_hdr_t))
+#define LOG_FLASH_SECTOR_PAGES (W25Qx_SECTOR_SIZE / W25Qx_PAGE_SIZE)
+
+/**
+ * @brief State of the flash sink.
+ */
+typedef struct {
+    W25Qx_Device *dev;               /*!< Flash chip */
+    uint32_t base;                   /*!< Start of the region */
+    uint32_t pages;                  /*!< Pages in the region, a multiple of a sector */
+    uint32_t seq;                    /*!< Sequence number of the page being filled */
+    uint32_t erased;                 /*!< Pages from seq up to this sequence number are erased */
+    uint16_t fill;                   /*!< Message bytes in the page buffer */
+    TickType_t first;                /*!< Tick the first buffered byte arrived */
+    uint8_t erase_failed;            /*!< Last erase ahead failed, wait before the next one */
+    TickType_t erase_tick;           /*!< Tick of the last failed erase */
+    uint8_t page[W25Qx_PAGE_SIZE] __attribute__((aligned(4))); /*!< Page being filled, header first */
+} log_flash_t;
+
+static inline uint32_t log_flash_addr(const log_flash_t *f, uint32_t seq) {
+    return f->base + (seq % f->pages) * W25Qx_PAGE_SIZE;
+}
+
+/**
+ * @brief Read a page header and check it belongs at its place in the ring.
+ *
+ * @param f Region (dev, base and pages set).
+ * @param index Page index in the region.
+ * @param hdr Receives the header.
+ * @return uint8_t 1 if the page holds messages, 0 if it is erased or torn.
+ */
+static uint8_t log_flash_header(const log_flash_t *f, uint32_t index, sys_log_flash_hdr_t *hdr) {
+    if (!W25Qx_ReadData(f->dev, f->base + index * W25Qx_PAGE_SIZE, hdr, sizeof(*hdr))) {
+        return 0;
+    }
+    return hdr->magic == SYS_LOG_FLASH_MAGIC && hdr->used <= LOG_FLASH_PAYLOAD && hdr->seq % f->pages == index;
+}
+
+/**
+ * @brief Find the newest page of the region.
+ *
+ * Sectors are filled in order, each from its first page; a write cut off
+ * by a reset leaves the rest of its sector unused. So from any written
+ * sector start j with sequence s, "sector start j + d holds s + d sectors"
+ * is true up to the newest sector and false after it, and within that
+ * sector "page k holds its first sequence + k" is true up to the newest
+ * page: two binary searches.
+ *
+ * @param f Region (dev, base and pages set).
+ * @param newest Receives the sequence number of the newest page.
+ * @return uint8_t 1 if the region holds any page, 0 if it is empty.
+ */
+static uint8_t log_flash_find(const log_flash_t *f, uint32_t *newest) {
+    sys_log_flash_hdr_t hdr;
+    uint32_t sectors = f->pages / LOG_FLASH_SECTOR_PAGES;
+    uint32_t start = sectors;
+
+    for (uint32_t i = 0; i < sectors; i++) {
+        if (log_flash_header(f, i * LOG_FLASH_SECTOR_PAGES, &hdr)) {
+            start = i;
+            break;
+        }
     }
-    f_close(&logFile);
+    if (start == sectors) {
+        return 0;
+    }
+
+    uint32_t seq = hdr.seq;
+    uint32_t lo = 0, hi = sectors;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (log_flash_header(f, (start + mid) % sectors * LOG_FLASH_SECTOR_PAGES, &hdr)
+                && hdr.seq == seq + mid * LOG_FLASH_SECTOR_PAGES) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    seq += lo * LOG_FLASH_SECTOR_PAGES;
+    uint32_t first = seq % f->pages;
+    lo = 0, hi = LOG_FLASH_SECTOR_PAGES;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (log_flash_header(f, first + mid, &hdr) && hdr.seq == seq + mid) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    *newest = seq + lo;
+    return 1;
+}
+
+/**
+ * @brief Erase the next sector ahead of the write head.
+ *
+ * @param f Sink state.
+ * @return uint8_t 1 on success, 0 otherwise.
+ */
+static uint8_t log_flash_erase_next(log_flash_t *f) {
+    if (!W25Qx_EraseSector(f->dev, log_flash_addr(f, f->erased))) {
+        return 0;
+    }
+    f->erased += LOG_FLASH_SECTOR_PAGES;
+    return 1;
+}
+
+/**
+ * @brief Check whether the erase-ahead window needs another sector.
+ */
+static inline uint8_t log_flash_erase_due(const log_flash_t *f) {
+    uint32_t window = LOG_FLASH_ERASE_AHEAD * LOG_FLASH_SECTOR_PAGES;
+    // Never reach around into the sector being filled
+    if (window > f->pages - LOG_FLASH_SECTOR_PAGES) {
+        window = f->pages - LOG_FLASH_SECTOR_PAGES;
+    }
+    return f->erased - f->seq < window;
+}
+
+/**
+ * @brief Ticks until the next erase ahead may run.
+ *
+ * A failed erase (e.g. the chip busy with an async job) is retried after
+ * LOG_FLASH_FLUSH_MS rather than right away.
+ *
+ * @param f Sink state.
+ * @return TickType_t 0 to erase now, portMAX_DELAY if no erase is due.
+ */
+static TickType_t log_flash_erase_wait(const log_flash_t *f) {
+    if (!log_flash_erase_due(f)) {
+        return portMAX_DELAY;
+    }
+    if (!f->erase_failed) {
+        return 0;
+    }
+    TickType_t elapsed = xTaskGetTickCount() - f->erase_tick;
+    return (elapsed >= pdMS_TO_TICKS(LOG_FLASH_FLUSH_MS)) ? 0 : pdMS_TO_TICKS(LOG_FLASH_FLUSH_MS) - elapsed;
+}
+
+/**
+ * @brief Program the page buffer and move to the next page.
+ *
+ * @param f Sink state.
+ * @return uint8_t 1 on success, 0 otherwise.
+ */
+static uint8_t log_flash_flush(log_flash_t *f) {
+    sys_log_flash_hdr_t *hdr = (sys_log_flash_hdr_t*)f->page;
+
+    if (f->fill == 0) {
+        return 1;
+    }
+    // Only after a burst outran the idle erases
+    while (f->erased == f->seq) {
+        if (!log_flash_erase_next(f)) {
+            f->first = xTaskGetTickCount(); // Keep the page, try again after LOG_FLASH_FLUSH_MS
+            return 0;
+        }
+    }
+
+    hdr->magic = SYS_LOG_FLASH_MAGIC;
+    hdr->used = f->fill;
+    hdr->seq = f->seq;
+    uint8_t ok = W25Qx_WriteData(f->dev, log_flash_addr(f, f->seq), f->page, sizeof(*hdr) + f->fill);
+    f->seq++;
+    f->fill = 0;
+    return ok;
+}
+
+/**
+ * @brief Append a message to the page buffer, programming each page that fills up.
+ *
+ * @param f Sink state.
+ * @param data Message bytes.
+ * @param size Message size in bytes.
+ */
+static void log_flash_append(log_flash_t *f, const uint8_t *data, uint32_t size) {
+    while (size) {
+        uint32_t chunk = LOG_FLASH_PAYLOAD - f->fill;
+        if (chunk > size) chunk = size;
+
+        if (f->fill == 0) {
+            f->first = xTaskGetTickCount();
+        }
+        memcpy(f->page + sizeof(sys_log_flash_hdr_t) + f->fill, data, chunk);
+        f->fill += chunk;
+        data += chunk;
+        size -= chunk;
+
+        while (f->fill == LOG_FLASH_PAYLOAD && !log_flash_flush(f)) {
+            // The page could not be erased: wait, new messages stay in the arena meanwhile
+            ITM_SendString("Flash: Log write failed\n");
+            vTaskDelay(pdMS_TO_TICKS(LOG_FLASH_FLUSH_MS));
+        }
+    }
+}
+
+/**
+ * @brief Find where to continue writing after a restart.
+ *
+ * @param f Sink state with dev, base and pages set.
+ */
+static void log_flash_mount(log_flash_t *f) {
+    sys_log_flash_hdr_t hdr;
+    uint32_t newest;
+
+    f->seq = log_flash_find(f, &newest) ? newest + 1 : 0;
+    f->fill = 0;
+
+    // The rest of the newest sector is still erased, unless a write was cut off there
+    uint32_t sector_end = (f->seq + LOG_FLASH_SECTOR_PAGES - 1) / LOG_FLASH_SECTOR_PAGES * LOG_FLASH_SECTOR_PAGES;
+    W25Qx_ReadData(f->dev, log_flash_addr(f, f->seq), &hdr, sizeof(hdr));
+    if (hdr.magic != 0xFFFFu || hdr.used != 0xFFFFu || hdr.seq != 0xFFFFFFFFu) {
+        f->seq = sector_end;
+    }
+    f->erased = sector_end;
+}
+
+/**
+ * @brief Read back a flash log region, oldest page first.
+ *
+ * Meant for post-mortem dumps, e.g. at boot; do not call it while the
+ * flash sink writes to the same chip.
+ *
+ * @param dev Flash chip.
+ * @param base Start of the log region.
+ * @param size Size of the log region.
+ * @param out Called with the messages of each page, in order.
+ * @param ctx Passed to out.
+ * @return uint32_t Number of pages read.
+ */
+uint32_t SYS_LOG_FlashRead(W25Qx_Device *dev, uint32_t base, uint32_t size,
+                           void (*out)(void *ctx, const uint8_t *data, uint16_t len), void *ctx) {
+    log_flash_t f = { .dev = dev, .base = base, .pages = size / W25Qx_SECTOR_SIZE * LOG_FLASH_SECTOR_PAGES };
+    uint8_t data[LOG_FLASH_PAYLOAD];
+    uint32_t newest, count = 0;
+
+    if (f.pages == 0 || !log_flash_find(&f, &newest)) {
+        return 0;
+    }
+
+    // Pages of the erased window in between simply fail the check
+    uint32_t seq = (newest >= f.pages - 1) ? newest - (f.pages - 1) : 0;
+    for (; seq != newest + 1; seq++) {
+        sys_log_flash_hdr_t hdr;
+        uint32_t index = seq % f.pages;
+        if (!log_flash_header(&f, index, &hdr) || hdr.seq != seq) continue;
+        if (!W25Qx_ReadData(dev, base + index * W25Qx_PAGE_SIZE + sizeof(hdr), data, hdr.used)) break;
+        out(ctx, data, hdr.used);
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Thread for storing logs in a W25Qx flash region.
+ *
+ * Messages are packed into 256-byte pages, each programmed once when it
+ * fills, LOG_FLASH_FLUSH_MS after its first message or right after an
+ * ERROR message. While idle the task erases up to LOG_FLASH_ERASE_AHEAD
+ * sectors ahead of the write head, so sector erases rarely delay a write.
+ * A failed erase is retried every LOG_FLASH_FLUSH_MS.
+ *
+ * @param arg Unused parameter.
+ */
+void LogTask_Flash(void *arg) {
+    static log_flash_t flash;
+
+    flash.dev = logger.settings.flash;
+    flash.base = logger.settings.flash_base;
+    flash.pages = logger.settings.flash_size / W25Qx_SECTOR_SIZE * LOG_FLASH_SECTOR_PAGES;
+    if (flash.dev == NULL || flash.base % W25Qx_SECTOR_SIZE != 0
+            || flash.pages < (LOG_FLASH_ERASE_AHEAD + 2) * LOG_FLASH_SECTOR_PAGES) {
+        ITM_SendString("Flash: Bad log region\n");
+        log_sink_stop(SYS_LOG_SINK_FLASH);
+    }
+    log_flash_mount(&flash);
 
     while (1) {
-        if (xQueueReceive(mmcQueue, logMessage, portMAX_DELAY) == pdPASS) {
-            if (f_open(&logFile, filePath, FA_WRITE | FA_OPEN_APPEND) == FR_OK) {
-                UINT bytesWritten;
-                f_write(&logFile, logMessage, strlen(logMessage), &bytesWritten);
-                currentFileSize += bytesWritten;
-                f_close(&logFile);
-                if (currentFileSize >= logger.settings.file_size) {
-                    if (ManageLogFiles(filePath) != FR_OK) ITM_SendString("MMC: Log manager failed\n");
-                    else currentFileSize = 0;
+        TickType_t timeout = portMAX_DELAY;
+        if (flash.fill) {
+            TickType_t elapsed = xTaskGetTickCount() - flash.first;
+            timeout = (elapsed >= pdMS_TO_TICKS(LOG_FLASH_FLUSH_MS)) ? 0 : pdMS_TO_TICKS(LOG_FLASH_FLUSH_MS) - elapsed;
+        }
+        TickType_t erase = log_flash_erase_wait(&flash);
+        if (erase < timeout) {
+            timeout = erase;
+        }
+
+        const log_rec_t *rec = log_sink_wait(SYS_LOG_SINK_FLASH, timeout);
+        if (rec == NULL) {
+            // Idle: a due page flush first, then erase ahead
+            if (flash.fill && xTaskGetTickCount() - flash.first >= pdMS_TO_TICKS(LOG_FLASH_FLUSH_MS)) {
+                if (!log_flash_flush(&flash)) ITM_SendString("Flash: Log write failed\n");
+            } else if (log_flash_erase_wait(&flash) == 0) {
+                flash.erase_failed = !log_flash_erase_next(&flash);
+                if (flash.erase_failed) {
+                    flash.erase_tick = xTaskGetTickCount();
+                    ITM_SendString("Flash: Log erase failed\n");
                 }
             }
+            continue;
+        }
+
+        uint8_t level = rec->level;
+        log_flash_append(&flash, (const uint8_t*)(rec + 1), rec->size);
+        log_sink_release(SYS_LOG_SINK_FLASH);
+
+        if (level == SYS_LOG_ERROR && !log_flash_flush(&flash)) {
+            ITM_SendString("Flash: Log write failed\n");
         }
     }
 }
@@ -0,0 +1,213 @@
+/**
+ * @file TimedBuffer.c
+ * @brief Implementation of the timestamped circular buffer.
+ *
+ * Searches run on offsets from the oldest timestamp: in a sorted ring that
+ * spans less than 2^31 ticks these offsets are monotonic even when the
+ * counter wraps, so plain unsigned compares are enough.
+ */
+
+#include "TimedBuffer.h"
+#include <string.h>
+
+static inline uint16_t tb_slot(const TimedBuffer *tb, uint16_t i) {
+    uint32_t s = (uint32_t)tb->oldest + i;
+    return (s >= tb->size) ? s - tb->size : s;
+}
+
+static inline uint32_t tb_stamp(const TimedBuffer *tb, uint16_t i) {
+    return tb->stamps[tb_slot(tb, i)];
+}
+
+/**
+ * Whether every item is older than max_age at time now.
+ *
+ * A counter that ran on for 2^31 ticks or more while the buffer sat idle
+ * looks like a step back in time. Only a step back within max_age is taken
+ * as out of order; anything further behind can only be an expired buffer.
+ */
+static inline uint8_t tb_stale(const TimedBuffer *tb, uint32_t now) {
+    uint32_t gap = now - tb_stamp(tb, tb->count - 1);
+    return tb->max_age && gap > tb->max_age && 0u - gap > tb->max_age;
+}
+
+/** First index whose offset from the oldest stamp is >= key (strict = 0) or > key (strict = 1). */
+static uint16_t tb_lower_bound(const TimedBuffer *tb, uint32_t t, uint8_t strict) {
+    if (tb->count == 0) return 0;
+
+    uint32_t base = tb_stamp(tb, 0);
+    if ((int32_t)(t - base) < 0) return 0;
+
+    uint32_t key = t - base;
+    uint16_t lo = 0, hi = tb->count;
+    while (lo < hi) {
+        uint16_t mid = lo + (hi - lo) / 2;
+        uint32_t off = tb_stamp(tb, mid) - base;
+        if (off < key || (strict && off == key)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Initialize an empty buffer on caller-provided storage.
+ *
+ * @param tb Pointer to the buffer.
+ * @param data Item storage of size * item_size bytes.
+ * @param stamps Timestamp storage of size words.
+ * @param size Maximum number of items.
+ * @param item_size Size of a single item in bytes.
+ * @param max_age Expiry age in ticks below 2^31, 0 to disable.
+ */
+void TB_Init(TimedBuffer *tb, void *data, uint32_t *stamps, uint16_t size, uint16_t item_size, uint32_t max_age) {
+    tb->data = data;
+    tb->stamps = stamps;
+    tb->size = size;
+    tb->item_size = item_size;
+    tb->oldest = 0;
+    tb->count = 0;
+    tb->max_age = max_age;
+}
+
+/**
+ * @brief Append an item, overwriting the oldest one when the buffer is full.
+ *
+ * Items older than max_age relative to @p t are expired first, also after
+ * an idle gap of 2^31 ticks or more.
+ *
+ * @param tb Pointer to the buffer.
+ * @param t Timestamp of the item, not earlier than the newest one stored.
+ * @param item Pointer to the item.
+ * @return uint8_t 1 if stored, 0 if @p t is out of order.
+ */
+uint8_t TB_Push(TimedBuffer *tb, uint32_t t, const void *item) {
+    if (tb->count && tb_stale(tb, t)) {
+        tb->count = 0;
+    }
+    if (tb->count && (int32_t)(t - tb_stamp(tb, tb->count - 1)) < 0) {
+        return 0;
+    }
+    TB_Expire(tb, t);
+
+    uint16_t s;
+    if (tb->count == tb->size) {
+        s = tb->oldest;
+        tb->oldest = tb_slot(tb, 1);
+    } else {
+        s = tb_slot(tb, tb->count);
+        tb->count++;
+    }
+    tb->stamps[s] = t;
+    memcpy((char*)tb->data + (uint32_t)s * tb->item_size, item, tb->item_size);
+    return 1;
+}
+
+/**
+ * @brief Drop items older than max_age at time @p now.
+ *
+ * @param tb Pointer to the buffer.
+ * @param now Current timestamp.
+ * @return uint16_t Number of items dropped.
+ */
+uint16_t TB_Expire(TimedBuffer *tb, uint32_t now) {
+    if (tb->max_age == 0 || tb->count == 0) return 0;
+
+    if (tb_stale(tb, now)) {
+        uint16_t n = tb->count;
+        tb->count = 0;
+        return n;
+    }
+
+    // Everything stamped before now - max_age goes, found with one search
+    uint16_t n = tb_lower_bound(tb, now - tb->max_age, 0);
+    tb->oldest = tb_slot(tb, n);
+    tb->count -= n;
+    return n;
+}
+
+/**
+ * @brief Get the i-th oldest item.
+ *
+ * @param tb Pointer to the buffer.
+ * @param i Index from the oldest item, less than tb->count.
+ * @param t Receives the timestamp, may be NULL.
+ * @return void* Pointer to the item, NULL if @p i is out of range.
+ */
+void *TB_At(const TimedBuffer *tb, uint16_t i, uint32_t *t) {
+    if (i >= tb->count) return NULL;
+
+    uint16_t s = tb_slot(tb, i);
+    if (t != NULL) *t = tb->stamps[s];
+    return (char*)tb->data + (uint32_t)s * tb->item_size;
+}
+
+/**
+ * @brief Index of the first item with a timestamp at or after @p t.
+ *
+ * @param tb Pointer to the buffer.
+ * @param t Timestamp to look up.
+ * @return uint16_t Index from the oldest item, tb->count if every item is earlier.
+ */
+uint16_t TB_FindAtOrAfter(const TimedBuffer *tb, uint32_t t) {
+    return tb_lower_bound(tb, t, 0);
+}
+
+/**
+ * @brief Index of the first item with a timestamp after @p t.
+ *
+ * @param tb Pointer to the buffer.
+ * @param t Timestamp to look up.
+ * @return uint16_t Index from the oldest item, tb->count if no item is later.
+ */
+uint16_t TB_FindAfter(const TimedBuffer *tb, uint32_t t) {
+    return tb_lower_bound(tb, t, 1);
+}
+
+/**
+ * @brief Index of the item whose timestamp is closest to @p t.
+ *
+ * @param tb Pointer to the buffer.
+ * @param t Timestamp to look up.
+ * @return int32_t Index from the oldest item, -1 if the buffer is empty.
+ */
+int32_t TB_Nearest(const TimedBuffer *tb, uint32_t t) {
+    if (tb->count == 0) return -1;
+
+    uint16_t i = tb_lower_bound(tb, t, 0);
+    if (i == 0) return 0;
+    if (i == tb->count) return tb->count - 1;
+
+    // Compare distances to the neighbours on both sides of t
+    uint32_t after = tb_stamp(tb, i) - t;
+    uint32_t before = t - tb_stamp(tb, i - 1);
+    return (before <= after) ? i - 1 : i;
+}
+
+/**
+ * @brief Items with from <= timestamp < to, as up to two contiguous regions.
+ *
+ * @param tb Pointer to the buffer.
+ * @param from Start of the interval (inclusive).
+ * @param to End of the interval (exclusive).
+ * @param span Receives the regions, oldest first; span[1].count is 0 unless the range wraps.
+ * @param first Receives the index of the first item in the range, may be NULL.
+ * @return uint16_t Number of items in the range.
+ */
+uint16_t TB_Range(const TimedBuffer *tb, uint32_t from, uint32_t to, CB_Span span[2], uint16_t *first) {
+    uint16_t lo = tb_lower_bound(tb, from, 0);
+    uint16_t hi = tb_lower_bound(tb, to, 0);
+    uint16_t n = (hi > lo) ? hi - lo : 0;
+    uint16_t s = tb_slot(tb, lo);
+    uint16_t run = tb->size - s;
+
+    if (run > n) run = n;
+    span[0].ptr = (char*)tb->data + (uint32_t)s * tb->item_size;
+    span[0].count = run;
+    span[1].ptr = tb->data;
+    span[1].count = n - run;
+    if (first != NULL) *first = lo;
+    return n;
+}
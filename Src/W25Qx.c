@@ -11,11 +11,22 @@
 #include "W25Qx.h"
 #include "main.h"
 #include <string.h>
+#include <stdatomic.h>
 
 // Internal buffers for SPI communication
-static uint8_t txbuf[4];
+static uint8_t txbuf[4 + W25Qx_READ_DUMMY];
 static uint8_t rxbuf[4];
 
+// Steps of a running asynchronous job
+enum {
+    W25Qx_PHASE_IDLE,   // No job running
+    W25Qx_PHASE_POLL,   // Status poll in flight
+    W25Qx_PHASE_WAIT,   // Chip busy, next poll from W25Qx_AsyncProcess()
+    W25Qx_PHASE_DATA    // Read or page program data in flight
+};
+
+static void W25Qx_AsyncStart(W25Qx_Device *dev);
+
 /**
  * @brief Initialize the W25Qx device.
  *
@@ -25,6 +36,9 @@ static uint8_t rxbuf[4];
 uint8_t W25Qx_Init(W25Qx_Device *dev) {
     dev->txbuf = txbuf;
     dev->rxbuf = rxbuf;
+    dev->job_head = 0;
+    dev->job_count = 0;
+    dev->phase = W25Qx_PHASE_IDLE;
 
     // Check JEDEC ID
     txbuf[0] = W25Qx_CMD_JEDEC_ID;
@@ -65,11 +79,18 @@ uint8_t W25Qx_Init(W25Qx_Device *dev) {
 /**
  * @brief Wait for the W25Qx device to be ready.
  *
+ * Fails while asynchronous jobs are queued: the blocking functions must
+ * not interleave with them.
+ *
  * @param dev Pointer to the W25Qx device structure.
  * @param timeout Timeout in milliseconds.
  * @return 1 if the device is ready, 0 otherwise.
  */
 uint8_t W25Qx_WaitForReady(W25Qx_Device *dev, uint32_t timeout) {
+    if (dev->job_count) {
+        return 0;
+    }
+
     uint32_t start = HAL_GetTick();
     while (HAL_GetTick() - start < timeout) {
         txbuf[0] = W25Qx_CMD_READ_SR1;
@@ -85,13 +106,15 @@ uint8_t W25Qx_WaitForReady(W25Qx_Device *dev, uint32_t timeout) {
 }
 
 /**
- * @brief Erase a 4KB sector.
+ * @brief Erase one sector or block and wait for it.
  *
  * @param dev Pointer to the W25Qx device structure.
- * @param address Address of the sector to erase.
+ * @param command Sector or block erase command.
+ * @param address Address of the sector or block.
+ * @param timeout Longest time the erase may take, in milliseconds.
  * @return 1 if the operation succeeds, 0 otherwise.
  */
-uint8_t W25Qx_EraseSector(W25Qx_Device *dev, uint32_t address) {
+static uint8_t W25Qx_EraseBlock(W25Qx_Device *dev, uint8_t command, uint32_t address, uint32_t timeout) {
     if (!W25Qx_WaitForReady(dev, W25Qx_TIMEOUT)) {
         return 0;
     }
@@ -101,7 +124,7 @@ uint8_t W25Qx_EraseSector(W25Qx_Device *dev, uint32_t address) {
     HAL_SPI_Transmit(dev->spi, txbuf, 1, HAL_MAX_DELAY);
     HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
 
-    txbuf[0] = W25Qx_CMD_SECTOR_ERASE;
+    txbuf[0] = command;
     txbuf[1] = (address >> 16) & 0xFF;
     txbuf[2] = (address >> 8) & 0xFF;
     txbuf[3] = address & 0xFF;
@@ -110,12 +133,74 @@ uint8_t W25Qx_EraseSector(W25Qx_Device *dev, uint32_t address) {
     HAL_SPI_Transmit(dev->spi, txbuf, 4, HAL_MAX_DELAY);
     HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
 
-    return W25Qx_WaitForReady(dev, W25Qx_TIMEOUT);
+    return W25Qx_WaitForReady(dev, timeout);
+}
+
+/**
+ * @brief Erase a 4KB sector.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param address Address of the sector to erase.
+ * @return 1 if the operation succeeds, 0 otherwise.
+ */
+uint8_t W25Qx_EraseSector(W25Qx_Device *dev, uint32_t address) {
+    return W25Qx_EraseBlock(dev, W25Qx_CMD_SECTOR_ERASE, address, W25Qx_TIMEOUT_SECTOR_ERASE);
+}
+
+/**
+ * @brief Time limit of a chip erase.
+ *
+ * An unknown part gets the limit of the largest supported one (16MB).
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @return uint32_t Timeout in milliseconds.
+ */
+static uint32_t W25Qx_ChipEraseTimeout(const W25Qx_Device *dev) {
+    uint32_t mb = dev->capacity >> 20;
+    return (mb ? mb : 16) * W25Qx_TIMEOUT_CHIP_ERASE_MB;
+}
+
+/**
+ * @brief Pick the largest erase that starts at an address and stays in a range.
+ *
+ * Sizes divide each other, so taking the largest aligned one at every
+ * step gives the fewest commands.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param address Sector aligned address the erase starts at.
+ * @param remaining Bytes left in the range from address.
+ * @param command Receives the erase command.
+ * @param timeout Receives its time limit in milliseconds.
+ * @return uint32_t Bytes the erase covers.
+ */
+static uint32_t W25Qx_ErasePlan(const W25Qx_Device *dev, uint32_t address, uint32_t remaining,
+                                uint8_t *command, uint32_t *timeout) {
+    if (address == 0 && dev->capacity && remaining >= dev->capacity) {
+        *command = W25Qx_CMD_CHIP_ERASE;
+        *timeout = W25Qx_ChipEraseTimeout(dev);
+        return dev->capacity;
+    }
+    if (address % W25Qx_BLOCK64_SIZE == 0 && remaining >= W25Qx_BLOCK64_SIZE) {
+        *command = W25Qx_CMD_BLOCK64_ERASE;
+        *timeout = W25Qx_TIMEOUT_BLOCK64_ERASE;
+        return W25Qx_BLOCK64_SIZE;
+    }
+    if (address % W25Qx_BLOCK32_SIZE == 0 && remaining >= W25Qx_BLOCK32_SIZE) {
+        *command = W25Qx_CMD_BLOCK32_ERASE;
+        *timeout = W25Qx_TIMEOUT_BLOCK32_ERASE;
+        return W25Qx_BLOCK32_SIZE;
+    }
+    *command = W25Qx_CMD_SECTOR_ERASE;
+    *timeout = W25Qx_TIMEOUT_SECTOR_ERASE;
+    return W25Qx_SECTOR_SIZE;
 }
 
 /**
  * @brief Read data from the W25Qx device.
  *
+ * Uses W25Qx_READ_CMD. Reads longer than one HAL transfer are split into
+ * several commands.
+ *
  * @param dev Pointer to the W25Qx device structure.
  * @param address Address to read from.
  * @param buffer Pointer to the buffer to store read data.
@@ -127,15 +212,24 @@ uint8_t W25Qx_ReadData(W25Qx_Device *dev, uint32_t address, void *buffer, uint32
         return 0;
     }
 
-    txbuf[0] = W25Qx_CMD_READ;
-    txbuf[1] = (address >> 16) & 0xFF;
-    txbuf[2] = (address >> 8) & 0xFF;
-    txbuf[3] = address & 0xFF;
+    uint8_t *data = buffer;
+    while (length > 0) {
+        uint32_t chunk = (length > W25Qx_XFER_MAX) ? W25Qx_XFER_MAX : length;
 
-    HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(dev->spi, txbuf, 4, HAL_MAX_DELAY);
-    HAL_SPI_Receive(dev->spi, buffer, length, HAL_MAX_DELAY);
-    HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
+        txbuf[0] = W25Qx_READ_CMD;
+        txbuf[1] = (address >> 16) & 0xFF;
+        txbuf[2] = (address >> 8) & 0xFF;
+        txbuf[3] = address & 0xFF;
+
+        HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_RESET);
+        HAL_SPI_Transmit(dev->spi, txbuf, 4 + W25Qx_READ_DUMMY, HAL_MAX_DELAY);
+        HAL_SPI_Receive(dev->spi, data, chunk, HAL_MAX_DELAY);
+        HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
+
+        address += chunk;
+        data += chunk;
+        length -= chunk;
+    }
 
     return 1;
 }
@@ -206,23 +300,395 @@ uint8_t W25Qx_EraseChip(W25Qx_Device *dev) {
     HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
 
     // Wait for the operation to complete
-    return W25Qx_WaitForReady(dev, W25Qx_TIMEOUT*100); // Chip erase can take a long time
+    return W25Qx_WaitForReady(dev, W25Qx_ChipEraseTimeout(dev)); // Chip erase can take a long time
 }
 
+/**
+ * @brief Erase the sectors covering a range with as few commands as possible.
+ *
+ * Aligned 64KB and 32KB blocks inside the range go with one block erase
+ * each, the rest with 4KB sector erases; a range covering the whole
+ * device becomes a chip erase.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param start_address Starting address of the first sector to erase.
+ * @param length Number of bytes to erase (will be aligned to sector boundaries).
+ * @return 1 if the operation succeeds, 0 otherwise.
+ */
 uint8_t W25Qx_EraseSectors(W25Qx_Device *dev, uint32_t start_address, uint32_t length) {
     uint32_t end_address = start_address + length;
     uint32_t current_address = start_address;
 
-    // Align start address to sector boundary
+    // Align both ends to sector boundaries, so the planner sees whole sectors
     current_address -= current_address % W25Qx_SECTOR_SIZE;
+    end_address += (W25Qx_SECTOR_SIZE - end_address % W25Qx_SECTOR_SIZE) % W25Qx_SECTOR_SIZE;
 
     while (current_address < end_address) {
-        if (!W25Qx_EraseSector(dev, current_address)) {
+        uint8_t command;
+        uint32_t timeout;
+        uint32_t size = W25Qx_ErasePlan(dev, current_address, end_address - current_address, &command, &timeout);
+
+        uint8_t ok = (command == W25Qx_CMD_CHIP_ERASE) ? W25Qx_EraseChip(dev)
+                                                       : W25Qx_EraseBlock(dev, command, current_address, timeout);
+        if (!ok) {
             return 0; // Abort on failure
         }
-        current_address += W25Qx_SECTOR_SIZE;
+        current_address += size;
     }
 
     return 1;
 }
 
+
+/**
+ * @brief Send a command with a 24-bit address, leaving CS low.
+ *
+ * Blocking, but only a few bytes: the payload that follows goes by DMA.
+ * Writes are preceded by Write Enable, reads followed by their dummy byte.
+ * Runs in the SPI interrupt: the HAL timeout needs the time base interrupt
+ * to preempt it.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param command Command byte.
+ * @param address Address sent after the command.
+ * @return 1 if the operation succeeds, 0 otherwise (CS is released).
+ */
+static uint8_t W25Qx_AsyncCommand(W25Qx_Device *dev, uint8_t command, uint32_t address) {
+    uint8_t read = (command == W25Qx_READ_CMD);
+    uint16_t size = read ? 4 + W25Qx_READ_DUMMY : (command == W25Qx_CMD_CHIP_ERASE) ? 1 : 4;
+
+    if (!read) {
+        dev->cmd[0] = W25Qx_CMD_WRITE_ENABLE;
+        HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_RESET);
+        HAL_StatusTypeDef res = HAL_SPI_Transmit(dev->spi, dev->cmd, 1, W25Qx_TIMEOUT);
+        HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
+        if (res != HAL_OK) {
+            return 0;
+        }
+    }
+
+    dev->cmd[0] = command;
+    dev->cmd[1] = (address >> 16) & 0xFF;
+    dev->cmd[2] = (address >> 8) & 0xFF;
+    dev->cmd[3] = address & 0xFF;
+
+    HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_RESET);
+    if (HAL_SPI_Transmit(dev->spi, dev->cmd, size, W25Qx_TIMEOUT) != HAL_OK) {
+        HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Finish the running job and start the next queued one.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param ok Result passed to the callback.
+ */
+static void W25Qx_AsyncFinish(W25Qx_Device *dev, uint8_t ok) {
+    W25Qx_Job *job = &dev->jobs[dev->job_head];
+    W25Qx_Callback callback = job->callback;
+    void *ctx = job->ctx;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    dev->phase = W25Qx_PHASE_IDLE;
+    dev->job_head = (dev->job_head + 1) % W25Qx_QUEUE_LEN;
+    dev->job_count--;
+    __set_PRIMASK(primask);
+
+    // The callback may queue a job itself, which then starts right away
+    if (callback) {
+        callback(dev, ok, ctx);
+    }
+    if (dev->job_count && dev->phase == W25Qx_PHASE_IDLE) {
+        W25Qx_AsyncStart(dev);
+    }
+}
+
+/**
+ * @brief Read the status register by DMA.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ */
+static void W25Qx_AsyncPoll(W25Qx_Device *dev) {
+    dev->phase = W25Qx_PHASE_POLL;
+    dev->poll_last = HAL_GetTick();
+    dev->poll_tx[0] = W25Qx_CMD_READ_SR1;
+
+    HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_RESET);
+    if (HAL_SPI_TransmitReceive_DMA(dev->spi, dev->poll_tx, dev->poll_rx, W25Qx_POLL_LEN) != HAL_OK) {
+        HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
+        W25Qx_AsyncFinish(dev, 0);
+    }
+}
+
+/**
+ * @brief Wait for a program or erase, polling from W25Qx_AsyncProcess().
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param timeout Limit of the wait in ms.
+ * @param period Time between polls in ms.
+ */
+static void W25Qx_AsyncWait(W25Qx_Device *dev, uint32_t timeout, uint32_t period) {
+    dev->poll_start = HAL_GetTick();
+    dev->poll_last = dev->poll_start;
+    dev->poll_timeout = timeout;
+    dev->poll_period = period;
+    atomic_thread_fence(memory_order_release); // Poll fields before the phase, read in the tick hook
+    dev->phase = W25Qx_PHASE_WAIT;
+}
+
+/**
+ * @brief Start the next transfer of the running job, the chip being ready.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ */
+static void W25Qx_AsyncNext(W25Qx_Device *dev) {
+    W25Qx_Job *job = &dev->jobs[dev->job_head];
+    uint32_t address = job->address + dev->done;
+    uint32_t remaining = job->length - dev->done;
+    HAL_StatusTypeDef res;
+
+    if (dev->done >= job->length) {
+        W25Qx_AsyncFinish(dev, 1);
+        return;
+    }
+
+    switch (job->type) {
+        case W25Qx_JOB_READ:
+            dev->chunk = (remaining > W25Qx_XFER_MAX) ? W25Qx_XFER_MAX : remaining;
+            if (!W25Qx_AsyncCommand(dev, W25Qx_READ_CMD, address)) {
+                W25Qx_AsyncFinish(dev, 0);
+                return;
+            }
+            dev->phase = W25Qx_PHASE_DATA;
+            res = HAL_SPI_Receive_DMA(dev->spi, job->data + dev->done, dev->chunk);
+            break;
+
+        case W25Qx_JOB_PROGRAM:
+            dev->chunk = W25Qx_PAGE_SIZE - address % W25Qx_PAGE_SIZE;
+            if (dev->chunk > remaining) {
+                dev->chunk = remaining;
+            }
+            if (!W25Qx_AsyncCommand(dev, W25Qx_CMD_PAGE_PROGRAM, address)) {
+                W25Qx_AsyncFinish(dev, 0);
+                return;
+            }
+            dev->phase = W25Qx_PHASE_DATA;
+            res = HAL_SPI_Transmit_DMA(dev->spi, job->data + dev->done, dev->chunk);
+            break;
+
+        default: { // W25Qx_JOB_ERASE, the command alone starts it
+            uint8_t command;
+            uint32_t timeout;
+            uint32_t size = W25Qx_ErasePlan(dev, address, remaining, &command, &timeout);
+
+            if (!W25Qx_AsyncCommand(dev, command, address)) {
+                W25Qx_AsyncFinish(dev, 0);
+                return;
+            }
+            HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
+            dev->done += size;
+            W25Qx_AsyncWait(dev, timeout, timeout / W25Qx_POLL_ERASE_DIV);
+            return;
+        }
+    }
+
+    if (res != HAL_OK) {
+        HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
+        W25Qx_AsyncFinish(dev, 0);
+    }
+}
+
+/**
+ * @brief Start the job at the head of the queue.
+ *
+ * A blocking call may have left a page program running, so every job
+ * begins with a status poll.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ */
+static void W25Qx_AsyncStart(W25Qx_Device *dev) {
+    dev->done = 0;
+    dev->poll_start = HAL_GetTick();
+    dev->poll_timeout = W25Qx_TIMEOUT;
+    dev->poll_period = W25Qx_POLL_PROGRAM_MS;
+    W25Qx_AsyncPoll(dev);
+}
+
+/**
+ * @brief Add a job to the queue, starting it if the device is idle.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param job Job to copy into the queue.
+ * @return 1 if the job is queued, 0 if the queue is full.
+ */
+static uint8_t W25Qx_AsyncSubmit(W25Qx_Device *dev, const W25Qx_Job *job) {
+    uint8_t start;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (dev->job_count == W25Qx_QUEUE_LEN) {
+        __set_PRIMASK(primask);
+        return 0;
+    }
+    dev->jobs[(dev->job_head + dev->job_count) % W25Qx_QUEUE_LEN] = *job;
+    start = (dev->job_count++ == 0);
+    __set_PRIMASK(primask);
+
+    // No transfer is in flight, so no interrupt can start it concurrently
+    if (start) {
+        W25Qx_AsyncStart(dev);
+    }
+    return 1;
+}
+
+/**
+ * @brief Queue an asynchronous read.
+ *
+ * Data moves by SPI DMA; a read longer than W25Qx_XFER_MAX is split into
+ * several commands.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param address Address to read from.
+ * @param buffer Receives the data, must stay valid until the callback.
+ * @param length Number of bytes to read.
+ * @param callback Called when the read is done, may be NULL.
+ * @param ctx Passed to the callback.
+ * @return 1 if the job is queued, 0 if the queue is full.
+ */
+uint8_t W25Qx_ReadAsync(W25Qx_Device *dev, uint32_t address, void *buffer, uint32_t length,
+                        W25Qx_Callback callback, void *ctx) {
+    W25Qx_Job job = { W25Qx_JOB_READ, address, buffer, length, callback, ctx };
+    return W25Qx_AsyncSubmit(dev, &job);
+}
+
+/**
+ * @brief Queue an asynchronous program of erased flash.
+ *
+ * The data is split at page boundaries. Each page is sent by DMA, then
+ * W25Qx_AsyncProcess() polls the busy flag with short status reads
+ * until the chip is ready for the next page.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param address Address to write to.
+ * @param buffer Data to write, must stay valid until the callback.
+ * @param length Number of bytes to write.
+ * @param callback Called when the last page is programmed, may be NULL.
+ * @param ctx Passed to the callback.
+ * @return 1 if the job is queued, 0 if the queue is full.
+ */
+uint8_t W25Qx_ProgramAsync(W25Qx_Device *dev, uint32_t address, const void *buffer, uint32_t length,
+                           W25Qx_Callback callback, void *ctx) {
+    W25Qx_Job job = { W25Qx_JOB_PROGRAM, address, (uint8_t*)buffer, length, callback, ctx };
+    return W25Qx_AsyncSubmit(dev, &job);
+}
+
+/**
+ * @brief Queue an asynchronous erase of the 4KB sectors covering a range.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param address Starting address, aligned down to a sector.
+ * @param length Number of bytes to erase.
+ * @param callback Called when the last sector is erased, may be NULL.
+ * @param ctx Passed to the callback.
+ * @return 1 if the job is queued, 0 if the queue is full.
+ */
+uint8_t W25Qx_EraseAsync(W25Qx_Device *dev, uint32_t address, uint32_t length,
+                         W25Qx_Callback callback, void *ctx) {
+    uint32_t start = address - address % W25Qx_SECTOR_SIZE;
+    uint32_t end = address + length;
+    end += (W25Qx_SECTOR_SIZE - end % W25Qx_SECTOR_SIZE) % W25Qx_SECTOR_SIZE;
+    W25Qx_Job job = { W25Qx_JOB_ERASE, start, NULL, end - start, callback, ctx };
+    return W25Qx_AsyncSubmit(dev, &job);
+}
+
+/**
+ * @brief Check whether all asynchronous jobs of a device are done.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @return 1 if the job queue is empty, 0 otherwise.
+ */
+uint8_t W25Qx_AsyncIdle(W25Qx_Device *dev) {
+    return dev->job_count == 0;
+}
+
+/**
+ * @brief Poll the busy flag of a running program or erase when it is due.
+ *
+ * Call every millisecond, e.g. from vApplicationTickHook() or the HAL
+ * time base timer callback. While the chip is busy no SPI transfer is in
+ * flight: each poll is one short DMA transfer, every W25Qx_POLL_PROGRAM_MS
+ * during a page program and every 1/W25Qx_POLL_ERASE_DIV of the time
+ * limit during an erase.
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ */
+void W25Qx_AsyncProcess(W25Qx_Device *dev) {
+    // Only this function leaves the wait phase: no transfer or interrupt races it
+    if (dev->phase != W25Qx_PHASE_WAIT) {
+        return;
+    }
+    atomic_thread_fence(memory_order_acquire); // Pairs with the fence in W25Qx_AsyncWait()
+    if (HAL_GetTick() - dev->poll_last >= dev->poll_period) {
+        W25Qx_AsyncPoll(dev);
+    }
+}
+
+/**
+ * @brief SPI transfer complete handler
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param hspi SPI handle passed to the HAL callback.
+ *
+ * @note This function should be called from HAL_SPI_TxCpltCallback,
+ *       HAL_SPI_RxCpltCallback and HAL_SPI_TxRxCpltCallback
+ */
+void W25Qx_SPI_IRQHandler(W25Qx_Device *dev, SPI_HandleTypeDef *hspi) {
+    if (hspi != dev->spi || dev->phase == W25Qx_PHASE_IDLE) {
+        return;
+    }
+    HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
+
+    if (dev->phase == W25Qx_PHASE_POLL) {
+        // Byte 0 was clocked in during the command
+        for (uint32_t i = 1; i < W25Qx_POLL_LEN; i++) {
+            if ((dev->poll_rx[i] & W25Qx_SR1_BUSY) == 0) {
+                W25Qx_AsyncNext(dev);
+                return;
+            }
+        }
+        if (HAL_GetTick() - dev->poll_start >= dev->poll_timeout) {
+            W25Qx_AsyncFinish(dev, 0);
+        } else {
+            dev->phase = W25Qx_PHASE_WAIT;
+        }
+        return;
+    }
+
+    // Data transfer done: reads go on, page programs wait for the chip
+    dev->done += dev->chunk;
+    if (dev->jobs[dev->job_head].type == W25Qx_JOB_READ) {
+        W25Qx_AsyncNext(dev);
+    } else {
+        W25Qx_AsyncWait(dev, W25Qx_TIMEOUT, W25Qx_POLL_PROGRAM_MS);
+    }
+}
+
+/**
+ * @brief SPI error handler
+ *
+ * @param dev Pointer to the W25Qx device structure.
+ * @param hspi SPI handle passed to the HAL callback.
+ *
+ * @note This function should be called from HAL_SPI_ErrorCallback
+ */
+void W25Qx_SPI_ErrorHandler(W25Qx_Device *dev, SPI_HandleTypeDef *hspi) {
+    if (hspi != dev->spi || dev->phase == W25Qx_PHASE_IDLE) {
+        return;
+    }
+    HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
+    W25Qx_AsyncFinish(dev, 0);
+}
@@ -0,0 +1,249 @@
+/**
+ * @file W25Qx_Cache.c
+ * @brief Write-back sector cache for W25Qx SPI Flash memory.
+ *
+ * @author [Nate Hunter]
+ * @date [16.10.2026]
+ * @version 1.0
+ */
+
+#include "W25Qx_Cache.h"
+#include <string.h>
+
+/**
+ * @brief Initialize a cache.
+ *
+ * @param cache Pointer to the cache structure.
+ * @param dev Initialized device to cache.
+ * @param lines Storage for the lines, e.g. a static array.
+ * @param count Number of lines, at least 1.
+ * @return uint8_t 1 if successful, 0 if there are no lines.
+ */
+uint8_t W25Qx_CacheInit(W25Qx_Cache *cache, W25Qx_Device *dev, W25Qx_CacheLine *lines, uint8_t count) {
+    if (lines == NULL || count == 0) {
+        return 0;
+    }
+    cache->dev = dev;
+    cache->lines = lines;
+    cache->count = count;
+    cache->clock = 0;
+    W25Qx_CacheInvalidate(cache);
+    return 1;
+}
+
+/**
+ * @brief Find the line holding a sector.
+ *
+ * @param cache Pointer to the cache structure.
+ * @param sector Sector address.
+ * @return W25Qx_CacheLine* The line, NULL on a miss.
+ */
+static W25Qx_CacheLine *W25Qx_CacheFind(W25Qx_Cache *cache, uint32_t sector) {
+    for (uint8_t i = 0; i < cache->count; i++) {
+        if (cache->lines[i].address == sector) {
+            cache->lines[i].stamp = ++cache->clock;
+            return &cache->lines[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Write a dirty line back to the flash.
+ *
+ * Without a pending erase only the changed pages are programmed: their
+ * new contents only clear bits of what the flash holds. After an erase,
+ * every page that is not blank is programmed.
+ *
+ * @param cache Pointer to the cache structure.
+ * @param line Line to flush.
+ * @return 1 if the operation succeeds, 0 otherwise (the line stays dirty).
+ */
+static uint8_t W25Qx_CacheFlush(W25Qx_Cache *cache, W25Qx_CacheLine *line) {
+    if (line->dirty == 0) {
+        return 1;
+    }
+
+    if (line->erase) {
+        if (!W25Qx_EraseSector(cache->dev, line->address)) {
+            return 0;
+        }
+        line->erase = 0;
+        line->dirty = 0;
+
+        for (uint32_t p = 0; p < W25Qx_CACHE_PAGES; p++) {
+            const uint8_t *page = line->data + p * W25Qx_PAGE_SIZE;
+            for (uint32_t i = 0; i < W25Qx_PAGE_SIZE; i++) {
+                if (page[i] != 0xFF) {
+                    line->dirty |= 1u << p;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (uint32_t p = 0; p < W25Qx_CACHE_PAGES; p++) {
+        if ((line->dirty & (1u << p)) == 0) {
+            continue;
+        }
+        if (!W25Qx_WriteData(cache->dev, line->address + p * W25Qx_PAGE_SIZE,
+                             line->data + p * W25Qx_PAGE_SIZE, W25Qx_PAGE_SIZE)) {
+            return 0;
+        }
+        line->dirty &= ~(1u << p);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Load a sector into the least recently used line, flushing it first.
+ *
+ * @param cache Pointer to the cache structure.
+ * @param sector Sector address.
+ * @return W25Qx_CacheLine* The line, NULL if the eviction or the read failed.
+ */
+static W25Qx_CacheLine *W25Qx_CacheLoad(W25Qx_Cache *cache, uint32_t sector) {
+    W25Qx_CacheLine *line = &cache->lines[0];
+
+    for (uint8_t i = 0; i < cache->count; i++) {
+        if (cache->lines[i].address == W25Qx_CACHE_NONE) {
+            line = &cache->lines[i];
+            break;
+        }
+        if (cache->lines[i].stamp < line->stamp) {
+            line = &cache->lines[i];
+        }
+    }
+
+    if (line->address != W25Qx_CACHE_NONE && !W25Qx_CacheFlush(cache, line)) {
+        return NULL;
+    }
+
+    line->address = W25Qx_CACHE_NONE;
+    if (!W25Qx_ReadData(cache->dev, sector, line->data, W25Qx_SECTOR_SIZE)) {
+        return NULL;
+    }
+    line->address = sector;
+    line->stamp = ++cache->clock;
+    line->dirty = 0;
+    line->erase = 0;
+    return line;
+}
+
+/**
+ * @brief Read data, including writes not flushed yet.
+ *
+ * @param cache Pointer to the cache structure.
+ * @param address Address to read from.
+ * @param buffer Pointer to the buffer to store read data.
+ * @param length Number of bytes to read.
+ * @return 1 if the operation succeeds, 0 otherwise.
+ */
+uint8_t W25Qx_CacheRead(W25Qx_Cache *cache, uint32_t address, void *buffer, uint32_t length) {
+    uint8_t *dst = buffer;
+
+    while (length > 0) {
+        uint32_t offset = address % W25Qx_SECTOR_SIZE;
+        uint32_t chunk = W25Qx_SECTOR_SIZE - offset;
+        if (chunk > length) {
+            chunk = length;
+        }
+
+        W25Qx_CacheLine *line = W25Qx_CacheFind(cache, address - offset);
+        if (line) {
+            memcpy(dst, line->data + offset, chunk);
+        } else if (!W25Qx_ReadData(cache->dev, address, dst, chunk)) {
+            return 0;
+        }
+
+        address += chunk;
+        dst += chunk;
+        length -= chunk;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Write data; the flash does not need to be erased.
+ *
+ * @param cache Pointer to the cache structure.
+ * @param address Address to write to.
+ * @param buffer Pointer to the data to write.
+ * @param length Number of bytes to write.
+ * @return 1 if the operation succeeds, 0 if a line could not be loaded or evicted.
+ */
+uint8_t W25Qx_CacheWrite(W25Qx_Cache *cache, uint32_t address, const void *buffer, uint32_t length) {
+    const uint8_t *src = buffer;
+
+    while (length > 0) {
+        uint32_t offset = address % W25Qx_SECTOR_SIZE;
+        uint32_t chunk = W25Qx_SECTOR_SIZE - offset;
+        if (chunk > length) {
+            chunk = length;
+        }
+
+        W25Qx_CacheLine *line = W25Qx_CacheFind(cache, address - offset);
+        if (line == NULL) {
+            line = W25Qx_CacheLoad(cache, address - offset);
+            if (line == NULL) {
+                return 0;
+            }
+        }
+
+        // Unchanged bytes leave the line clean, a bit going 0 -> 1 needs an erase
+        for (uint32_t i = 0; i < chunk; i++) {
+            uint8_t old = line->data[offset + i];
+            if (old == src[i]) {
+                continue;
+            }
+            if (src[i] & ~old) {
+                line->erase = 1;
+            }
+            line->data[offset + i] = src[i];
+            line->dirty |= 1u << ((offset + i) / W25Qx_PAGE_SIZE);
+        }
+
+        address += chunk;
+        src += chunk;
+        length -= chunk;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Flush every dirty line to the flash.
+ *
+ * Lines stay cached.
+ *
+ * @param cache Pointer to the cache structure.
+ * @return 1 if the operation succeeds, 0 otherwise.
+ */
+uint8_t W25Qx_CacheSync(W25Qx_Cache *cache) {
+    uint8_t ok = 1;
+
+    for (uint8_t i = 0; i < cache->count; i++) {
+        if (cache->lines[i].address != W25Qx_CACHE_NONE && !W25Qx_CacheFlush(cache, &cache->lines[i])) {
+            ok = 0;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Drop every line without flushing it.
+ *
+ * Call after writing the device around the cache.
+ *
+ * @param cache Pointer to the cache structure.
+ */
+void W25Qx_CacheInvalidate(W25Qx_Cache *cache) {
+    for (uint8_t i = 0; i < cache->count; i++) {
+        cache->lines[i].address = W25Qx_CACHE_NONE;
+        cache->lines[i].stamp = 0;
+        cache->lines[i].dirty = 0;
+        cache->lines[i].erase = 0;
+    }
+}
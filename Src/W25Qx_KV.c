@@ -0,0 +1,764 @@
+/**
+ * @file W25Qx_KV.c
+ * @brief Log-structured key-value store on W25Qx SPI Flash memory.
+ *
+ * @author [Nate Hunter]
+ * @date [16.10.2026]
+ * @version 1.0
+ */
+
+#include "W25Qx_KV.h"
+#include <stddef.h>
+#include <string.h>
+
+#define KV_NONE         0xFF
+#define KV_HEADER_SIZE  sizeof(W25Qx_KVHeader)
+#define KV_MASK         (W25Qx_KV_INDEX_SIZE - 1)
+#define KV_CHUNK        64
+
+_Static_assert((W25Qx_KV_INDEX_SIZE & KV_MASK) == 0, "W25Qx_KV_INDEX_SIZE must be a power of two");
+
+/**
+ * @brief Update a CRC-32 (IEEE 802.3, reflected) with a block of bytes.
+ *
+ * Nibble table: small enough for flash, fast enough for short records.
+ *
+ * @param crc Running CRC, start with 0xFFFFFFFF and invert the result.
+ * @param data Bytes to add.
+ * @param length Number of bytes.
+ * @return uint32_t Updated CRC.
+ */
+static uint32_t W25Qx_KVCrc(uint32_t crc, const void *data, uint32_t length) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    const uint8_t *p = data;
+
+    while (length--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return crc;
+}
+
+/**
+ * @brief Hash a key (FNV-1a).
+ */
+static uint32_t W25Qx_KVHash(const char *key, uint8_t key_len) {
+    uint32_t hash = 2166136261u;
+
+    for (uint8_t i = 0; i < key_len; i++) {
+        hash = (hash ^ (uint8_t)key[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static inline uint16_t W25Qx_KVSize(uint8_t key_len, uint16_t value_len) {
+    return (sizeof(W25Qx_KVRecord) + key_len + value_len + 3) & ~3u;
+}
+
+static inline uint32_t W25Qx_KVAddress(const W25Qx_KV *kv, uint32_t offset) {
+    return kv->base + offset;
+}
+
+/**
+ * @brief Find the index slot of a key, checking the key stored in the flash.
+ *
+ * @param kv Pointer to the store structure.
+ * @param key Key bytes.
+ * @param key_len Key length.
+ * @param hash Key hash.
+ * @param rec Receives the record header if found, may be NULL.
+ * @return int32_t Slot index, -1 if the key is not indexed, -2 on a flash error.
+ */
+static int32_t W25Qx_KVFind(W25Qx_KV *kv, const char *key, uint8_t key_len, uint32_t hash, W25Qx_KVRecord *rec) {
+    struct {
+        W25Qx_KVRecord rec;
+        char key[W25Qx_KV_KEY_MAX];
+    } stored;
+
+    for (uint32_t i = hash & KV_MASK; kv->index[i].offset; i = (i + 1) & KV_MASK) {
+        if (kv->index[i].hash != hash) {
+            continue;
+        }
+        if (!W25Qx_ReadData(kv->dev, W25Qx_KVAddress(kv, kv->index[i].offset), &stored,
+                            sizeof(W25Qx_KVRecord) + key_len)) {
+            return -2;
+        }
+        if (stored.rec.key_len == key_len && memcmp(stored.key, key, key_len) == 0) {
+            if (rec) {
+                *rec = stored.rec;
+            }
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Take a free slot for a new key.
+ */
+static uint32_t W25Qx_KVInsert(W25Qx_KV *kv, uint32_t hash) {
+    uint32_t i = hash & KV_MASK;
+
+    while (kv->index[i].offset) {
+        i = (i + 1) & KV_MASK;
+    }
+    kv->count++;
+    return i;
+}
+
+/**
+ * @brief Empty a slot, moving later entries of its probe run back (no tombstones).
+ */
+static void W25Qx_KVRemove(W25Qx_KV *kv, uint32_t i) {
+    uint32_t j = i;
+
+    kv->index[i].offset = 0;
+    while (1) {
+        j = (j + 1) & KV_MASK;
+        if (kv->index[j].offset == 0) {
+            break;
+        }
+        // Entry j may move to i if i lies between its home slot and j
+        uint32_t home = kv->index[j].hash & KV_MASK;
+        if (((j - home) & KV_MASK) >= ((j - i) & KV_MASK)) {
+            kv->index[i] = kv->index[j];
+            kv->index[j].offset = 0;
+            i = j;
+        }
+    }
+    kv->count--;
+}
+
+/**
+ * @brief Point a key at a new record, turning its previous record into garbage.
+ *
+ * @param kv Pointer to the store structure.
+ * @param slot Slot of the key, -1 for a new key.
+ * @param hash Key hash.
+ * @param offset Record offset.
+ * @param size Record size.
+ * @param deleted The record is a deletion.
+ */
+static void W25Qx_KVIndex(W25Qx_KV *kv, int32_t slot, uint32_t hash, uint32_t offset, uint16_t size, uint8_t deleted) {
+    if (slot >= 0) {
+        W25Qx_KVEntry *old = &kv->index[slot];
+        kv->sector[old->offset / W25Qx_SECTOR_SIZE].live -= old->size;
+    } else {
+        slot = W25Qx_KVInsert(kv, hash);
+    }
+
+    kv->index[slot].hash = hash;
+    kv->index[slot].offset = offset;
+    kv->index[slot].size = size;
+    kv->index[slot].deleted = deleted;
+    kv->sector[offset / W25Qx_SECTOR_SIZE].live += size;
+}
+
+/**
+ * @brief Erase a sector and write its header, keeping the erase count.
+ *
+ * @param kv Pointer to the store structure.
+ * @param s Sector index.
+ * @return 1 if the operation succeeds, 0 otherwise.
+ */
+static uint8_t W25Qx_KVErase(W25Qx_KV *kv, uint8_t s) {
+    W25Qx_KVSector *sec = &kv->sector[s];
+    uint32_t address = W25Qx_KVAddress(kv, s * W25Qx_SECTOR_SIZE);
+
+    if (!W25Qx_EraseSector(kv->dev, address)) {
+        return 0;
+    }
+    sec->erases++;
+
+    // Only the erase count: seq stays erased until the sector is taken
+    W25Qx_KVHeader hdr = { W25Qx_KV_MAGIC, sec->erases, ~sec->erases,
+                           W25Qx_KV_FREE, W25Qx_KV_FREE, W25Qx_KV_FREE, W25Qx_KV_FREE };
+    if (!W25Qx_WriteData(kv->dev, address, &hdr, offsetof(W25Qx_KVHeader, seq))) {
+        return 0;
+    }
+
+    if (kv->active == s) {
+        kv->active = KV_NONE;
+    }
+    if (sec->seq != W25Qx_KV_FREE) {
+        kv->free++;
+    }
+    sec->seq = W25Qx_KV_FREE;
+    sec->source = KV_NONE;
+    sec->used = KV_HEADER_SIZE;
+    sec->live = 0;
+    return 1;
+}
+
+/**
+ * @brief Make the least worn free sector the active one.
+ *
+ * @param kv Pointer to the store structure.
+ * @param source Sector being garbage collected into it, KV_NONE for appends.
+ * @return 1 if the operation succeeds, 0 if no sector is free or on a flash error.
+ */
+static uint8_t W25Qx_KVAlloc(W25Qx_KV *kv, uint8_t source) {
+    uint8_t best = KV_NONE;
+
+    for (uint8_t s = 0; s < kv->sectors; s++) {
+        if (kv->sector[s].seq == W25Qx_KV_FREE && (best == KV_NONE || kv->sector[s].erases < kv->sector[best].erases)) {
+            best = s;
+        }
+    }
+    if (best == KV_NONE) {
+        return 0;
+    }
+
+    // Source first: a valid sequence number then vouches for it
+    uint32_t address = W25Qx_KVAddress(kv, best * W25Qx_SECTOR_SIZE);
+    uint32_t victim = (source == KV_NONE) ? W25Qx_KV_FREE : source;
+    uint32_t src[2] = { victim, ~victim };
+    uint32_t seq[2] = { kv->seq + 1, ~(kv->seq + 1) };
+    if (!W25Qx_WriteData(kv->dev, address + offsetof(W25Qx_KVHeader, source), src, sizeof(src))
+            || !W25Qx_WriteData(kv->dev, address + offsetof(W25Qx_KVHeader, seq), seq, sizeof(seq))) {
+        return 0;
+    }
+
+    kv->seq++;
+    kv->free--;
+    kv->active = best;
+    kv->sector[best].seq = kv->seq;
+    kv->sector[best].source = source;
+    kv->sector[best].used = KV_HEADER_SIZE;
+    kv->sector[best].live = 0;
+    return 1;
+}
+
+/**
+ * @brief Check whether the active sector has room for a record.
+ */
+static inline uint8_t W25Qx_KVFits(const W25Qx_KV *kv, uint16_t size) {
+    return kv->active != KV_NONE && W25Qx_SECTOR_SIZE - kv->sector[kv->active].used >= size;
+}
+
+/**
+ * @brief Check whether a sector was taken by a collection whose victim is not erased yet.
+ */
+static inline uint8_t W25Qx_KVPending(const W25Qx_KV *kv, uint8_t s) {
+    uint8_t victim = kv->sector[s].source;
+    return victim != KV_NONE && kv->sector[victim].seq != W25Qx_KV_FREE && kv->sector[victim].seq < kv->sector[s].seq;
+}
+
+/**
+ * @brief Pick the sector to garbage collect.
+ *
+ * Normally the one with the most superseded data; a sector far less worn
+ * than the most worn one goes first, whatever it holds. Its live records
+ * must fit where they move to: with a free sector left they always do,
+ * without one (after a failed collection) only in the rest of the active
+ * sector. The active sector itself qualifies only with a free sector.
+ *
+ * Without a free sector, a collection that took the active sector was
+ * cut off: its victim goes first, so the active sector holds nothing but
+ * copies of the victim's records until the victim is erased.
+ *
+ * @param kv Pointer to the store structure.
+ * @return uint8_t Sector index, KV_NONE if nothing can be reclaimed.
+ */
+static uint8_t W25Qx_KVVictim(const W25Qx_KV *kv) {
+    uint32_t most_worn = 0;
+    uint8_t cold = KV_NONE, dirty = KV_NONE;
+    uint16_t most_garbage = 0;
+    uint16_t room = W25Qx_SECTOR_SIZE;
+
+    if (kv->free == 0) {
+        if (kv->active == KV_NONE) {
+            return KV_NONE;
+        }
+        if (W25Qx_KVPending(kv, kv->active)) {
+            return kv->sector[kv->active].source;
+        }
+        room = W25Qx_SECTOR_SIZE - kv->sector[kv->active].used;
+    }
+
+    for (uint8_t s = 0; s < kv->sectors; s++) {
+        if (kv->sector[s].erases > most_worn) {
+            most_worn = kv->sector[s].erases;
+        }
+    }
+
+    for (uint8_t s = 0; s < kv->sectors; s++) {
+        const W25Qx_KVSector *sec = &kv->sector[s];
+        if (sec->seq == W25Qx_KV_FREE || (s == kv->active && kv->free == 0) || sec->live > room) {
+            continue;
+        }
+
+        if (most_worn - sec->erases >= W25Qx_KV_WEAR_DELTA
+                && (cold == KV_NONE || sec->erases < kv->sector[cold].erases)) {
+            cold = s;
+        }
+
+        uint16_t garbage = sec->used - KV_HEADER_SIZE - sec->live;
+        if (garbage > most_garbage
+                || (garbage == most_garbage && garbage && sec->erases < kv->sector[dirty].erases)) {
+            most_garbage = garbage;
+            dirty = s;
+        }
+    }
+    return (cold != KV_NONE) ? cold : dirty;
+}
+
+/**
+ * @brief Copy a live record to the active sector.
+ *
+ * @param kv Pointer to the store structure.
+ * @param e Index entry of the record, updated to the copy.
+ * @param victim Sector being garbage collected.
+ * @return 1 if the operation succeeds, 0 otherwise.
+ */
+static uint8_t W25Qx_KVMove(W25Qx_KV *kv, W25Qx_KVEntry *e, uint8_t victim) {
+    uint8_t buf[KV_CHUNK];
+
+    if (!W25Qx_KVFits(kv, e->size) && !W25Qx_KVAlloc(kv, victim)) {
+        return 0;
+    }
+
+    W25Qx_KVSector *dst = &kv->sector[kv->active];
+    uint32_t offset = kv->active * W25Qx_SECTOR_SIZE + dst->used;
+    // Claim the space first: a failed copy leaves garbage, never a gap appends would program over
+    dst->used += e->size;
+
+    for (uint16_t done = 0; done < e->size; done += KV_CHUNK) {
+        uint16_t n = (e->size - done < KV_CHUNK) ? e->size - done : KV_CHUNK;
+        if (!W25Qx_ReadData(kv->dev, W25Qx_KVAddress(kv, e->offset + done), buf, n)) {
+            return 0;
+        }
+        if (!W25Qx_WriteData(kv->dev, W25Qx_KVAddress(kv, offset + done), buf, n)) {
+            // Mount stops at the first bad record: append nothing after it
+            dst->used = W25Qx_SECTOR_SIZE;
+            return 0;
+        }
+    }
+
+    kv->sector[e->offset / W25Qx_SECTOR_SIZE].live -= e->size;
+    dst->live += e->size;
+    e->offset = offset;
+    return 1;
+}
+
+/**
+ * @brief Garbage collect one sector: move its live records away and erase it.
+ *
+ * Deletions are dropped instead of moved when the sector is the oldest in
+ * use: every older record of their keys is then in the same sector.
+ *
+ * @param kv Pointer to the store structure.
+ * @param victim Sector to collect, from W25Qx_KVVictim().
+ * @return 1 if the sector was erased, 0 on a flash error.
+ */
+static uint8_t W25Qx_KVCollect(W25Qx_KV *kv, uint8_t victim) {
+    if (victim == kv->active && !W25Qx_KVAlloc(kv, victim)) {
+        return 0;
+    }
+
+    uint8_t oldest = 1;
+    for (uint8_t s = 0; s < kv->sectors; s++) {
+        if (kv->sector[s].seq != W25Qx_KV_FREE && kv->sector[s].seq < kv->sector[victim].seq) {
+            oldest = 0;
+        }
+    }
+
+    for (uint32_t i = 0; i < W25Qx_KV_INDEX_SIZE; i++) {
+        W25Qx_KVEntry *e = &kv->index[i];
+        if (e->offset == 0 || e->offset / W25Qx_SECTOR_SIZE != victim) {
+            continue;
+        }
+        if (e->deleted && oldest) {
+            kv->sector[victim].live -= e->size;
+            W25Qx_KVRemove(kv, i);
+            i--; // A later entry may have moved into this slot
+            continue;
+        }
+        if (!W25Qx_KVMove(kv, e, victim)) {
+            return 0;
+        }
+    }
+
+    return W25Qx_KVErase(kv, victim);
+}
+
+/**
+ * @brief Make room for a record in the active sector.
+ *
+ * One free sector is kept back as the destination of garbage collection.
+ * Without it (a collection was cut off after taking it) the collection is
+ * finished first, before appends use up the room its records need.
+ *
+ * @param kv Pointer to the store structure.
+ * @param size Record size.
+ * @return 1 if the record fits, 0 if the store is full or on a flash error.
+ */
+static uint8_t W25Qx_KVReserve(W25Qx_KV *kv, uint16_t size) {
+    for (uint32_t tries = 0; tries <= 2u * kv->sectors; tries++) {
+        uint8_t fits = W25Qx_KVFits(kv, size);
+        if (fits && kv->free > 0) {
+            return 1;
+        }
+        if (!fits && kv->free > 1) {
+            if (!W25Qx_KVAlloc(kv, KV_NONE)) {
+                return 0;
+            }
+            continue;
+        }
+        uint8_t victim = W25Qx_KVVictim(kv);
+        if (victim == KV_NONE) {
+            return fits;
+        }
+        if (!W25Qx_KVCollect(kv, victim)) {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Append a record and index it.
+ *
+ * @param kv Pointer to the store structure.
+ * @param key Key bytes.
+ * @param key_len Key length.
+ * @param hash Key hash.
+ * @param value Value bytes.
+ * @param length Value length.
+ * @param flags Record flags.
+ * @return 1 if the operation succeeds, 0 otherwise.
+ */
+static uint8_t W25Qx_KVAppend(W25Qx_KV *kv, const char *key, uint8_t key_len, uint32_t hash,
+                              const void *value, uint16_t length, uint8_t flags) {
+    W25Qx_KVRecord rec = { key_len, flags, length, 0 };
+    uint16_t size = W25Qx_KVSize(key_len, length);
+
+    uint32_t crc = W25Qx_KVCrc(0xFFFFFFFF, &rec, offsetof(W25Qx_KVRecord, crc));
+    crc = W25Qx_KVCrc(crc, key, key_len);
+    rec.crc = ~W25Qx_KVCrc(crc, value, length);
+
+    if (!W25Qx_KVReserve(kv, size)) {
+        return 0;
+    }
+
+    // Collection may have moved index entries
+    int32_t slot = W25Qx_KVFind(kv, key, key_len, hash, NULL);
+    if (slot < -1) {
+        return 0;
+    }
+
+    W25Qx_KVSector *sec = &kv->sector[kv->active];
+    uint32_t offset = kv->active * W25Qx_SECTOR_SIZE + sec->used;
+    uint32_t address = W25Qx_KVAddress(kv, offset);
+    sec->used += size;
+
+    // Header first: if the rest is cut off, the CRC check drops the record
+    if (!W25Qx_WriteData(kv->dev, address, &rec, sizeof(rec))
+            || !W25Qx_WriteData(kv->dev, address + sizeof(rec), key, key_len)
+            || (length && !W25Qx_WriteData(kv->dev, address + sizeof(rec) + key_len, value, length))) {
+        // Mount stops at the first bad record: append nothing after it
+        sec->used = W25Qx_SECTOR_SIZE;
+        return 0;
+    }
+
+    W25Qx_KVIndex(kv, slot, hash, offset, size, flags & W25Qx_KV_DELETED);
+    return 1;
+}
+
+/**
+ * @brief Read and check the record at a sector position.
+ *
+ * @param kv Pointer to the store structure.
+ * @param offset Record offset in the partition.
+ * @param rec Receives the record header.
+ * @param key Receives the key.
+ * @return 1 if the record is valid, 0 otherwise.
+ */
+static uint8_t W25Qx_KVCheck(W25Qx_KV *kv, uint32_t offset, W25Qx_KVRecord *rec, char *key) {
+    uint8_t buf[KV_CHUNK];
+
+    if (!W25Qx_ReadData(kv->dev, W25Qx_KVAddress(kv, offset), rec, sizeof(*rec))) {
+        return 0;
+    }
+    if (rec->key_len == 0 || rec->key_len > W25Qx_KV_KEY_MAX || rec->value_len > W25Qx_KV_VALUE_MAX
+            || (rec->flags & ~W25Qx_KV_DELETED) || ((rec->flags & W25Qx_KV_DELETED) && rec->value_len)
+            || offset % W25Qx_SECTOR_SIZE + W25Qx_KVSize(rec->key_len, rec->value_len) > W25Qx_SECTOR_SIZE) {
+        return 0;
+    }
+
+    uint32_t address = W25Qx_KVAddress(kv, offset) + sizeof(*rec);
+    if (!W25Qx_ReadData(kv->dev, address, key, rec->key_len)) {
+        return 0;
+    }
+
+    uint32_t crc = W25Qx_KVCrc(0xFFFFFFFF, rec, offsetof(W25Qx_KVRecord, crc));
+    crc = W25Qx_KVCrc(crc, key, rec->key_len);
+    address += rec->key_len;
+    for (uint16_t done = 0; done < rec->value_len; done += KV_CHUNK) {
+        uint16_t n = (rec->value_len - done < KV_CHUNK) ? rec->value_len - done : KV_CHUNK;
+        if (!W25Qx_ReadData(kv->dev, address + done, buf, n)) {
+            return 0;
+        }
+        crc = W25Qx_KVCrc(crc, buf, n);
+    }
+    return ~crc == rec->crc;
+}
+
+/**
+ * @brief Index the records of a sector in order, up to the first blank or torn one.
+ *
+ * @param kv Pointer to the store structure.
+ * @param s Sector index.
+ * @return 1 if the operation succeeds, 0 on a flash error.
+ */
+static uint8_t W25Qx_KVScan(W25Qx_KV *kv, uint8_t s) {
+    W25Qx_KVSector *sec = &kv->sector[s];
+    W25Qx_KVRecord rec;
+    char key[W25Qx_KV_KEY_MAX];
+
+    sec->used = KV_HEADER_SIZE;
+    while (sec->used + sizeof(rec) <= W25Qx_SECTOR_SIZE) {
+        uint32_t offset = s * W25Qx_SECTOR_SIZE + sec->used;
+
+        if (!W25Qx_KVCheck(kv, offset, &rec, key)) {
+            break;
+        }
+
+        uint32_t hash = W25Qx_KVHash(key, rec.key_len);
+        int32_t slot = W25Qx_KVFind(kv, key, rec.key_len, hash, NULL);
+        if (slot < -1 || (slot == -1 && kv->count >= W25Qx_KV_INDEX_SIZE - 1)) {
+            return 0;
+        }
+        uint16_t size = W25Qx_KVSize(rec.key_len, rec.value_len);
+        W25Qx_KVIndex(kv, slot, hash, offset, size, rec.flags & W25Qx_KV_DELETED);
+        sec->used += size;
+    }
+    return 1;
+}
+
+/**
+ * @brief Check that the rest of a sector is erased, so appends can go there.
+ */
+static uint8_t W25Qx_KVBlank(W25Qx_KV *kv, uint8_t s) {
+    uint8_t buf[KV_CHUNK];
+    uint32_t address = W25Qx_KVAddress(kv, s * W25Qx_SECTOR_SIZE);
+
+    for (uint32_t pos = kv->sector[s].used; pos < W25Qx_SECTOR_SIZE; pos += KV_CHUNK) {
+        uint32_t n = (W25Qx_SECTOR_SIZE - pos < KV_CHUNK) ? W25Qx_SECTOR_SIZE - pos : KV_CHUNK;
+        if (!W25Qx_ReadData(kv->dev, address + pos, buf, n)) {
+            return 0;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            if (buf[i] != 0xFF) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Mount a partition, formatting sectors that hold no valid header.
+ *
+ * @param kv Pointer to the store structure.
+ * @param dev Initialized flash chip.
+ * @param base Partition start, sector aligned.
+ * @param size Partition size, 3 to W25Qx_KV_MAX_SECTORS sectors.
+ * @return 1 if the operation succeeds, 0 otherwise.
+ */
+uint8_t W25Qx_KVMount(W25Qx_KV *kv, W25Qx_Device *dev, uint32_t base, uint32_t size) {
+    uint8_t order[W25Qx_KV_MAX_SECTORS];
+    uint8_t used = 0;
+    uint32_t most_worn = 0;
+
+    if (base % W25Qx_SECTOR_SIZE || size / W25Qx_SECTOR_SIZE < 3 || size / W25Qx_SECTOR_SIZE > W25Qx_KV_MAX_SECTORS) {
+        return 0;
+    }
+
+    memset(kv, 0, sizeof(*kv));
+    kv->dev = dev;
+    kv->base = base;
+    kv->sectors = size / W25Qx_SECTOR_SIZE;
+    kv->active = KV_NONE;
+
+    // Classify sectors by header; seq 0 marks one that needs an erase
+    for (uint8_t s = 0; s < kv->sectors; s++) {
+        W25Qx_KVSector *sec = &kv->sector[s];
+        W25Qx_KVHeader hdr;
+
+        if (!W25Qx_ReadData(dev, W25Qx_KVAddress(kv, s * W25Qx_SECTOR_SIZE), &hdr, sizeof(hdr))) {
+            return 0;
+        }
+        sec->used = KV_HEADER_SIZE;
+        sec->seq = 0;
+        sec->source = KV_NONE;
+        if (hdr.magic != W25Qx_KV_MAGIC || hdr.erases_check != ~hdr.erases) {
+            continue;
+        }
+
+        sec->erases = hdr.erases;
+        if (hdr.erases > most_worn) {
+            most_worn = hdr.erases;
+        }
+        sec->source = (hdr.source_check == ~hdr.source && hdr.source < kv->sectors) ? hdr.source : KV_NONE;
+        if (hdr.seq == W25Qx_KV_FREE && hdr.seq_check == W25Qx_KV_FREE
+                && hdr.source == W25Qx_KV_FREE && hdr.source_check == W25Qx_KV_FREE) {
+            sec->seq = W25Qx_KV_FREE;
+            kv->free++;
+        } else if (hdr.seq_check == ~hdr.seq && hdr.seq != W25Qx_KV_FREE && hdr.seq != 0) {
+            sec->seq = hdr.seq;
+            if (hdr.seq > kv->seq) {
+                kv->seq = hdr.seq;
+            }
+            // Keep the sectors in use sorted oldest first
+            uint8_t i = used++;
+            while (i > 0 && kv->sector[order[i - 1]].seq > hdr.seq) {
+                order[i] = order[i - 1];
+                i--;
+            }
+            order[i] = s;
+        }
+    }
+
+    // Blank, torn or foreign sectors: erase with the worst known wear
+    for (uint8_t s = 0; s < kv->sectors; s++) {
+        if (kv->sector[s].seq == 0) {
+            kv->sector[s].erases = most_worn;
+            if (!W25Qx_KVErase(kv, s)) {
+                return 0;
+            }
+        }
+    }
+
+    // Replay records oldest first: the newest record of a key wins
+    for (uint8_t i = 0; i < used; i++) {
+        if (!W25Qx_KVScan(kv, order[i])) {
+            return 0;
+        }
+    }
+
+    // Append only after the newest records, and only where nothing was half written
+    if (used) {
+        uint8_t newest = order[used - 1];
+
+        kv->active = newest;
+        if (!W25Qx_KVBlank(kv, newest)) {
+            // A collection cut off while copying: the sector only holds copies
+            // of records still in the victim, so drop it and mount again
+            if (W25Qx_KVPending(kv, newest)) {
+                return W25Qx_KVErase(kv, newest) && W25Qx_KVMount(kv, dev, base, size);
+            }
+            kv->sector[newest].used = W25Qx_SECTOR_SIZE;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Read the value of a key.
+ *
+ * @param kv Pointer to the store structure.
+ * @param key Null-terminated key.
+ * @param value Receives up to size bytes of the value.
+ * @param size Size of the value buffer.
+ * @param length Receives the full value length, may be NULL.
+ * @return 1 if the key exists, 0 otherwise.
+ */
+uint8_t W25Qx_KVGet(W25Qx_KV *kv, const char *key, void *value, uint16_t size, uint16_t *length) {
+    size_t key_len = strlen(key);
+    W25Qx_KVRecord rec;
+
+    if (key_len == 0 || key_len > W25Qx_KV_KEY_MAX) {
+        return 0;
+    }
+    int32_t slot = W25Qx_KVFind(kv, key, key_len, W25Qx_KVHash(key, key_len), &rec);
+    if (slot < 0 || kv->index[slot].deleted) {
+        return 0;
+    }
+
+    if (length) {
+        *length = rec.value_len;
+    }
+    if (size > rec.value_len) {
+        size = rec.value_len;
+    }
+    return W25Qx_ReadData(kv->dev, W25Qx_KVAddress(kv, kv->index[slot].offset) + sizeof(rec) + key_len, value, size);
+}
+
+/**
+ * @brief Check whether a stored value equals new data.
+ */
+static uint8_t W25Qx_KVSame(W25Qx_KV *kv, int32_t slot, uint8_t key_len, const void *value, uint16_t length) {
+    uint8_t buf[KV_CHUNK];
+    uint32_t address = W25Qx_KVAddress(kv, kv->index[slot].offset) + sizeof(W25Qx_KVRecord) + key_len;
+
+    for (uint16_t done = 0; done < length; done += KV_CHUNK) {
+        uint16_t n = (length - done < KV_CHUNK) ? length - done : KV_CHUNK;
+        if (!W25Qx_ReadData(kv->dev, address + done, buf, n) || memcmp(buf, (const uint8_t*)value + done, n)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Store the value of a key.
+ *
+ * Writing the value a key already has costs no flash write.
+ *
+ * @param kv Pointer to the store structure.
+ * @param key Null-terminated key, 1 to W25Qx_KV_KEY_MAX bytes.
+ * @param value Value bytes.
+ * @param length Value length, up to W25Qx_KV_VALUE_MAX.
+ * @return 1 if the operation succeeds, 0 if the store is full or on a flash error.
+ */
+uint8_t W25Qx_KVSet(W25Qx_KV *kv, const char *key, const void *value, uint16_t length) {
+    size_t key_len = strlen(key);
+    W25Qx_KVRecord rec;
+
+    if (key_len == 0 || key_len > W25Qx_KV_KEY_MAX || length > W25Qx_KV_VALUE_MAX) {
+        return 0;
+    }
+
+    uint32_t hash = W25Qx_KVHash(key, key_len);
+    int32_t slot = W25Qx_KVFind(kv, key, key_len, hash, &rec);
+    if (slot < -1) {
+        return 0;
+    }
+    if (slot >= 0 && !kv->index[slot].deleted && rec.value_len == length
+            && W25Qx_KVSame(kv, slot, key_len, value, length)) {
+        return 1;
+    }
+    if (slot == -1 && kv->count >= W25Qx_KV_INDEX_SIZE * 3 / 4) {
+        return 0;
+    }
+
+    return W25Qx_KVAppend(kv, key, key_len, hash, value, length, 0);
+}
+
+/**
+ * @brief Delete a key.
+ *
+ * @param kv Pointer to the store structure.
+ * @param key Null-terminated key.
+ * @return 1 if the key was deleted, 0 if it did not exist or on a flash error.
+ */
+uint8_t W25Qx_KVDelete(W25Qx_KV *kv, const char *key) {
+    size_t key_len = strlen(key);
+
+    if (key_len == 0 || key_len > W25Qx_KV_KEY_MAX) {
+        return 0;
+    }
+
+    uint32_t hash = W25Qx_KVHash(key, key_len);
+    int32_t slot = W25Qx_KVFind(kv, key, key_len, hash, NULL);
+    if (slot < 0 || kv->index[slot].deleted) {
+        return 0;
+    }
+
+    return W25Qx_KVAppend(kv, key, key_len, hash, NULL, 0, W25Qx_KV_DELETED);
+}
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+@file syslog_decode.py
+@brief Host decoder for SysLog binary records (SYS_LOG_BINARY = 1).
+
+Records hold the addresses of the tag and format strings plus the raw
+argument words. The strings are read back from the firmware ELF, the
+arguments are formatted like the target's printf would.
+
+Usage:
+    syslog_decode.py firmware.elf SYS_log_000.bin [more.bin ...]
+    syslog_decode.py firmware.elf --udp [--port 20101] [--group 239.255.50.50]
+
+@author [Nate Hunter]
+@date [16.10.2026]
+@version 1.0
+"""
+
+import argparse
+import re
+import struct
+
+MAGIC = 0xB10C                         # timestamp in ms
+MAGIC_US = 0xB10D                      # 64-bit timestamp in us (SYS_LOG_TIMESTAMP_US)
+HEADERS = {
+    MAGIC: struct.Struct("<HBBIII"),       # magic, level, nwords, timestamp, tag, format
+    MAGIC_US: struct.Struct("<HBB4xQII"),
+}
+MAX_WORDS = 32                         # SYS_LOG_BIN_TEXT_WORDS, preformatted text records
+LEVELS = "NEWIDV"
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+SPEC = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfFgGaAcspn%])")
+
+
+class Elf32:
+    """Minimal little-endian ELF32 reader: maps target addresses to file bytes."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1:
+            raise ValueError("%s is not an ELF32 file" % path)
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, stype, flags, addr, offset, size = struct.unpack_from("<IIIIII", self.data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and stype != SHT_NOBITS and size:
+                self.sections.append((addr, offset, size))
+
+    def string(self, addr):
+        for base, offset, size in self.sections:
+            if base <= addr < base + size:
+                start = offset + addr - base
+                end = self.data.find(b"\0", start, offset + size)
+                return self.data[start:end if end >= 0 else offset + size].decode("latin-1")
+        return "<0x%08x>" % addr
+
+
+def render(elf, level, timestamp, tag, fmt, words):
+    """Format one record like sys_log_render() on the target."""
+    letter = LEVELS[level] if level < len(LEVELS) else "I"
+    head = "%s (%u) %s: " % (letter, timestamp, elf.string(tag))
+    text = elf.string(fmt)
+
+    # Preformatted text from sys_log_write travels in the argument words
+    if text == "" and words:
+        raw = struct.pack("<%dI" % len(words), *words)
+        return head + raw.split(b"\0", 1)[0].decode("latin-1")
+
+    pos = [0]
+
+    def take(n):
+        if pos[0] + n > len(words):
+            raise IndexError
+        value = words[pos[0]] | (words[pos[0] + 1] << 32 if n == 2 else 0)
+        pos[0] += n
+        return value
+
+    def convert(m):
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        if width == "*":
+            width = str(struct.unpack("<i", struct.pack("<I", take(1)))[0])
+        if prec == "*":
+            prec = str(struct.unpack("<i", struct.pack("<I", take(1)))[0])
+        spec = "%" + flags + (width or "") + ("." + prec if prec is not None else "")
+
+        if conv in "fFeEgGaA":
+            value = struct.unpack("<d", struct.pack("<Q", take(2)))[0]
+            if conv in "aA":
+                return value.hex()
+            return (spec + conv) % value
+
+        wide = length in ("ll", "j")
+        if conv in "di":
+            value = take(2 if wide else 1)
+            bits = 64 if wide else 32
+            if value >> (bits - 1):
+                value -= 1 << bits
+            if length == "h":
+                value = struct.unpack("<h", struct.pack("<H", value & 0xFFFF))[0]
+            elif length == "hh":
+                value = struct.unpack("<b", struct.pack("<B", value & 0xFF))[0]
+            return (spec + "d") % value
+        if conv in "ouxX":
+            value = take(2 if wide else 1)
+            if length == "h":
+                value &= 0xFFFF
+            elif length == "hh":
+                value &= 0xFF
+            return (spec + ("d" if conv == "u" else conv)) % value
+        if conv == "c":
+            return (spec + "c") % chr(take(1) & 0xFF)
+        if conv == "s":
+            addr = take(1)
+            return (spec + "s") % (elf.string(addr) if addr else "(null)")
+        if conv == "p":
+            return "0x%x" % take(1)
+        take(1)  # %n
+        return ""
+
+    try:
+        body = SPEC.sub(convert, text)
+    except IndexError:
+        body = SPEC.split(text)[0] + "<?>"
+    return head + body
+
+
+def records(data, resync=True):
+    """Yield (level, timestamp, tag, format, words) from a byte stream.
+
+    With resync the stream is searched for the next magic after a bad
+    record, otherwise it ends there. Log files are written contiguously, so
+    a bad record marks the end of the data: a preallocated file cut by a
+    power loss continues with stale clusters that must not be decoded.
+    """
+    i = 0
+    while i + 2 <= len(data):
+        header = HEADERS.get(struct.unpack_from("<H", data, i)[0])
+        if header is None or i + header.size > len(data):
+            if not resync:
+                return
+            i += 1
+            continue
+        _, level, nwords, timestamp, tag, fmt = header.unpack_from(data, i)
+        end = i + header.size + 4 * nwords
+        if nwords > MAX_WORDS or end > len(data):
+            if not resync:
+                return
+            i += 1
+            continue
+        words = list(struct.unpack_from("<%dI" % nwords, data, i + header.size))
+        yield level, timestamp, tag, fmt, words
+        i = end
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[2])
+    ap.add_argument("elf", help="firmware ELF with the format strings")
+    ap.add_argument("files", nargs="*", help="binary log files from the eMMC")
+    ap.add_argument("--udp", action="store_true", help="listen for UDP log datagrams")
+    ap.add_argument("--port", type=int, default=20101)
+    ap.add_argument("--group", default="239.255.50.50", help="multicast group, empty for unicast")
+    args = ap.parse_args()
+
+    elf = Elf32(args.elf)
+
+    for path in args.files:
+        with open(path, "rb") as f:
+            for rec in records(f.read(), resync=False):
+                print(render(elf, *rec))
+
+    if args.udp:
+        # Datagrams carry a sequence header, the receiver strips it and reports losses
+        import syslog_udp
+        syslog_udp.listen(args.port, args.group, elf=elf)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+@file syslog_udp.py
+@brief Host receiver for SysLog UDP datagrams.
+
+Each datagram starts with a sys_log_udp_hdr_t (magic, version, flags,
+node ID, message count, sequence number) followed by the messages back to
+back. Gaps in the sequence number of a node are reported as lost
+datagrams; a sequence that restarts at 0 is reported as a sink restart.
+Binary payloads (SYS_LOG_BINARY = 1) need the firmware ELF to be decoded.
+
+Usage:
+    syslog_udp.py [--port 20101] [--group 239.255.50.50] [--elf firmware.elf]
+    syslog_udp.py --group "" --bind 127.0.0.1      # unicast, local testing
+
+@author [Nate Hunter]
+@date [16.10.2026]
+@version 1.0
+"""
+
+import argparse
+import socket
+import struct
+import sys
+
+MAGIC = 0x4C53
+VERSION = 1
+FLAG_BINARY = 0x01
+HEADER = struct.Struct("<HBBHHI")      # magic, version, flags, node_id, count, seq
+
+
+def parse(data):
+    """Split a datagram into (node_id, seq, flags, payload), None if it is not a log datagram."""
+    if len(data) < HEADER.size:
+        return None
+    magic, version, flags, node, _count, seq = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        return None
+    return node, seq, flags, data[HEADER.size:]
+
+
+class SeqTracker:
+    """Per-node loss accounting from datagram sequence numbers."""
+
+    def __init__(self):
+        self.next = {}
+        self.received = 0
+        self.lost = 0
+
+    def update(self, node, seq):
+        """Returns a note for the log if the sequence is not the expected one."""
+        self.received += 1
+        expected = self.next.get(node)
+        self.next[node] = (seq + 1) & 0xFFFFFFFF
+        if expected is None or seq == expected:
+            return None
+        if seq == 0:
+            return "-- node %u: sink restarted" % node
+        gap = (seq - expected) & 0xFFFFFFFF
+        if gap < 0x80000000:
+            self.lost += gap
+            return "-- node %u: lost %u datagram(s), seq %u..%u" % (node, gap, expected, seq - 1)
+        return "-- node %u: out of order seq %u, expected %u" % (node, seq, expected)
+
+
+def messages(flags, payload, elf):
+    """Yield printable lines of one datagram payload."""
+    if flags & FLAG_BINARY:
+        if elf is None:
+            yield "<binary payload, pass --elf>"
+            return
+        import syslog_decode
+        for rec in syslog_decode.records(payload):
+            yield syslog_decode.render(elf, *rec)
+        return
+    for line in payload.decode("latin-1").splitlines():
+        yield line
+
+
+def listen(port, group, bind="", elf=None, out=sys.stdout):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind((bind, port))
+    if group:
+        mreq = struct.pack("4s4s", socket.inet_aton(group), socket.inet_aton("0.0.0.0"))
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+
+    seqs = SeqTracker()
+    try:
+        while True:
+            data, _ = sock.recvfrom(65535)
+            dgram = parse(data)
+            if dgram is None:
+                continue
+            node, seq, flags, payload = dgram
+            note = seqs.update(node, seq)
+            if note:
+                print(note, file=out)
+            for line in messages(flags, payload, elf):
+                print("[%u] %s" % (node, line), file=out)
+            out.flush()
+    except KeyboardInterrupt:
+        print("-- %u datagram(s) received, %u lost" % (seqs.received, seqs.lost), file=sys.stderr)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[2])
+    ap.add_argument("--port", type=int, default=20101)
+    ap.add_argument("--group", default="239.255.50.50", help="multicast group, empty for unicast")
+    ap.add_argument("--bind", default="", help="local address to listen on")
+    ap.add_argument("--elf", help="firmware ELF, needed for binary records")
+    args = ap.parse_args()
+
+    elf = None
+    if args.elf:
+        import syslog_decode
+        elf = syslog_decode.Elf32(args.elf)
+    listen(args.port, args.group, args.bind, elf)
+
+
+if __name__ == "__main__":
+    main()